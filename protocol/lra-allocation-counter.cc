@@ -0,0 +1,101 @@
+#include "lra-allocation-counter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+
+// Relaxed atomics: ns-3 runs on one thread, but the standard library may not
+std::atomic<bool> g_counting{false};
+std::atomic<uint64_t> g_allocations{0};
+std::atomic<uint64_t> g_bytes{0};
+std::atomic<uint64_t> g_frees{0};
+
+void*
+CountedAllocate(std::size_t size)
+{
+    if (g_counting.load(std::memory_order_relaxed))
+    {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+        g_bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+    void* pointer = std::malloc(size == 0 ? 1 : size);
+    if (!pointer)
+    {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void
+CountedFree(void* pointer)
+{
+    if (pointer && g_counting.load(std::memory_order_relaxed))
+    {
+        g_frees.fetch_add(1, std::memory_order_relaxed);
+    }
+    std::free(pointer);
+}
+
+} // namespace
+
+// The nothrow and aligned forms of the standard library go through these or through
+// malloc and free directly, so the counts stay consistent
+void*
+operator new(std::size_t size)
+{
+    return CountedAllocate(size);
+}
+
+void*
+operator new[](std::size_t size)
+{
+    return CountedAllocate(size);
+}
+
+void
+operator delete(void* pointer) noexcept
+{
+    CountedFree(pointer);
+}
+
+void
+operator delete[](void* pointer) noexcept
+{
+    CountedFree(pointer);
+}
+
+void
+operator delete(void* pointer, std::size_t) noexcept
+{
+    CountedFree(pointer);
+}
+
+void
+operator delete[](void* pointer, std::size_t) noexcept
+{
+    CountedFree(pointer);
+}
+
+namespace ns3
+{
+
+void
+LraSetAllocationCounting(bool enabled)
+{
+    g_counting.store(enabled, std::memory_order_relaxed);
+}
+
+LraAllocationCounts
+LraGetAllocationCounts()
+{
+    LraAllocationCounts counts;
+    counts.allocations = g_allocations.load(std::memory_order_relaxed);
+    counts.bytes = g_bytes.load(std::memory_order_relaxed);
+    counts.frees = g_frees.load(std::memory_order_relaxed);
+    return counts;
+}
+
+} // namespace ns3
@@ -0,0 +1,32 @@
+#ifndef LRA_ALLOCATION_COUNTER_H
+#define LRA_ALLOCATION_COUNTER_H
+
+#include <cstdint>
+
+/*
+ * Heap allocation counters of the whole process. lra-allocation-counter.cc
+ * replaces the global operator new and delete, so every allocation of the
+ * program is counted, ns-3 included, once counting is enabled. Until then the
+ * replacements only test one flag before calling malloc and free. Kept free of
+ * ns-3 includes like the other benchmark utilities.
+ */
+
+namespace ns3 {
+
+/// Allocations made while counting was enabled
+struct LraAllocationCounts
+{
+  uint64_t allocations = 0; ///< Calls to operator new
+  uint64_t bytes = 0; ///< Bytes requested from operator new
+  uint64_t frees = 0; ///< Calls to operator delete with a non-null pointer
+};
+
+/// Start or stop counting, off at the start of the process
+void LraSetAllocationCounting (bool enabled);
+
+/// \return the counts at the time of the call
+LraAllocationCounts LraGetAllocationCounts ();
+
+} // namespace ns3
+
+#endif /* LRA_ALLOCATION_COUNTER_H */
@@ -0,0 +1,61 @@
+#include "lra-checkpoint.h"
+
+#include <cstring>
+#include <fstream>
+
+namespace ns3
+{
+
+bool
+LraCheckpoint::Save(const std::string& filename) const
+{
+    std::ofstream file(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file)
+        return false;
+
+    LraCheckpointFileHeader header;
+    std::memcpy(header.magic, LRA_CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = LRA_CHECKPOINT_VERSION;
+    header.nodeCount = nodes.size();
+    header.timeNs = timeNs;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const auto& node : nodes)
+    {
+        LraCheckpointNodeRecord record = node.record;
+        record.linkCount = node.links.size();
+        file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+        file.write(reinterpret_cast<const char*>(node.links.data()),
+                   node.links.size() * sizeof(LraCheckpointLink));
+    }
+    return static_cast<bool>(file);
+}
+
+bool
+LraCheckpoint::Load(const std::string& filename)
+{
+    std::ifstream file(filename, std::ios::in | std::ios::binary);
+    LraCheckpointFileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, LRA_CHECKPOINT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != LRA_CHECKPOINT_VERSION)
+    {
+        return false;
+    }
+
+    timeNs = header.timeNs;
+    nodes.resize(header.nodeCount);
+    for (auto& node : nodes)
+    {
+        if (!file.read(reinterpret_cast<char*>(&node.record), sizeof(node.record)))
+            return false;
+        node.links.resize(node.record.linkCount);
+        if (!file.read(reinterpret_cast<char*>(node.links.data()),
+                       node.links.size() * sizeof(LraCheckpointLink)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace ns3
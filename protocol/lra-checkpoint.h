@@ -0,0 +1,76 @@
+#ifndef LRA_CHECKPOINT_H
+#define LRA_CHECKPOINT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Checkpoint of a converged network: node positions and LRA routing state.
+ * Kept free of ns-3 includes like the other file formats of the benchmark.
+ *
+ * A checkpoint file is a LraCheckpointFileHeader followed, for every node, by
+ * a LraCheckpointNodeRecord and its linkCount LraCheckpointLink entries, all in
+ * host byte order.
+ */
+
+namespace ns3 {
+
+static const char LRA_CHECKPOINT_MAGIC[8] = {'L', 'R', 'A', 'C', 'K', 'P', 'T', '\0'};
+static const uint32_t LRA_CHECKPOINT_VERSION = 1;
+
+struct LraCheckpointFileHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t nodeCount;
+  int64_t timeNs; ///< Simulation time of the capture
+};
+
+/// Link of a node with its orientation (-1 = unknown, 0 = incoming, 1 = outgoing)
+struct LraCheckpointLink
+{
+  uint32_t neighbor; ///< Neighbor address
+  int32_t state;
+};
+
+/// Fixed part of a node entry
+struct LraCheckpointNodeRecord
+{
+  uint32_t address; ///< Interface address, used to check the restored numbering
+  uint32_t sequence; ///< Sequence number of the last control message sent
+  uint32_t controlReceived; ///< Control messages processed
+  uint32_t duplicatesSuppressed; ///< Duplicate control messages discarded
+  double x, y, z; ///< Position (m)
+  uint32_t linkCount;
+  uint32_t reserved;
+};
+
+/// State of one node
+struct LraCheckpointNode
+{
+  LraCheckpointNodeRecord record;
+  std::vector<LraCheckpointLink> links;
+};
+
+/// Whole network state, by node index
+struct LraCheckpoint
+{
+  int64_t timeNs = 0;
+  std::vector<LraCheckpointNode> nodes;
+
+  /**
+   * Write the checkpoint.
+   * \return false if the file could not be written
+   */
+  bool Save (const std::string &filename) const;
+  /**
+   * Replace the content with the one of a checkpoint file.
+   * \return false if the file is missing, truncated or not a checkpoint
+   */
+  bool Load (const std::string &filename);
+};
+
+} // namespace ns3
+
+#endif /* LRA_CHECKPOINT_H */
@@ -0,0 +1,283 @@
+#include "lra-dag-snapshot.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace ns3
+{
+
+namespace
+{
+
+/// Compressed adjacency lists
+struct Csr
+{
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> targets;
+
+    Csr(uint32_t n, const std::vector<std::pair<uint32_t, uint32_t>>& arcs)
+        : offsets(n + 1, 0),
+          targets(arcs.size())
+    {
+        for (const auto& arc : arcs)
+            offsets[arc.first + 1]++;
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (const auto& arc : arcs)
+            targets[fill[arc.first]++] = arc.second;
+    }
+};
+
+uint32_t
+Find(std::vector<uint32_t>& parent, uint32_t x)
+{
+    while (parent[x] != x)
+    {
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+    return x;
+}
+
+/// Iterative Tarjan, returns the size of every strongly connected component
+std::vector<uint32_t>
+ComponentSizes(uint32_t n, const Csr& graph)
+{
+    const uint32_t unvisited = UINT32_MAX;
+    std::vector<uint32_t> index(n, unvisited);
+    std::vector<uint32_t> low(n, 0);
+    std::vector<bool> onStack(n, false);
+    std::vector<uint32_t> stack;
+    std::vector<std::pair<uint32_t, uint32_t>> callStack; // node, next edge
+    std::vector<uint32_t> sizes;
+    uint32_t counter = 0;
+
+    for (uint32_t root = 0; root < n; ++root)
+    {
+        if (index[root] != unvisited)
+            continue;
+        callStack.push_back({root, graph.offsets[root]});
+        index[root] = low[root] = counter++;
+        stack.push_back(root);
+        onStack[root] = true;
+
+        while (!callStack.empty())
+        {
+            uint32_t v = callStack.back().first;
+            uint32_t& edge = callStack.back().second;
+            if (edge < graph.offsets[v + 1])
+            {
+                uint32_t w = graph.targets[edge++];
+                if (index[w] == unvisited)
+                {
+                    index[w] = low[w] = counter++;
+                    stack.push_back(w);
+                    onStack[w] = true;
+                    callStack.push_back({w, graph.offsets[w]});
+                }
+                else if (onStack[w])
+                {
+                    low[v] = std::min(low[v], index[w]);
+                }
+                continue;
+            }
+
+            if (low[v] == index[v])
+            {
+                uint32_t size = 0;
+                uint32_t w;
+                do
+                {
+                    w = stack.back();
+                    stack.pop_back();
+                    onStack[w] = false;
+                    size++;
+                } while (w != v);
+                sizes.push_back(size);
+            }
+            callStack.pop_back();
+            if (!callStack.empty())
+            {
+                uint32_t parent = callStack.back().first;
+                low[parent] = std::min(low[parent], low[v]);
+            }
+        }
+    }
+    return sizes;
+}
+
+} // namespace
+
+LraDagMetrics
+AnalyzeDag(uint32_t nodeCount,
+           const std::vector<uint32_t>& sinks,
+           const std::vector<LraDagEdge>& edges)
+{
+    LraDagMetrics metrics;
+
+    std::vector<std::pair<uint32_t, uint32_t>> forward;
+    std::vector<std::pair<uint32_t, uint32_t>> backward;
+    std::vector<uint32_t> parent(nodeCount);
+    std::iota(parent.begin(), parent.end(), 0);
+    for (const auto& edge : edges)
+    {
+        if (edge.from >= nodeCount || edge.to >= nodeCount)
+            continue;
+        parent[Find(parent, edge.from)] = Find(parent, edge.to);
+        if (edge.state == 1)
+        {
+            forward.push_back({edge.from, edge.to});
+            backward.push_back({edge.to, edge.from});
+        }
+    }
+
+    // Loops
+    Csr out(nodeCount, forward);
+    for (uint32_t size : ComponentSizes(nodeCount, out))
+    {
+        if (size > 1)
+        {
+            metrics.cycles++;
+            metrics.nodesInCycles += size;
+        }
+    }
+
+    // Routes: breadth first from the sinks along reversed outgoing links
+    Csr in(nodeCount, backward);
+    std::vector<uint32_t> depth(nodeCount, UINT32_MAX);
+    std::vector<uint32_t> queue;
+    for (uint32_t sink : sinks)
+    {
+        if (sink < nodeCount && depth[sink] != 0)
+        {
+            depth[sink] = 0;
+            queue.push_back(sink);
+        }
+    }
+    uint64_t depthSum = 0;
+    uint32_t routed = 0;
+    for (size_t head = 0; head < queue.size(); ++head)
+    {
+        uint32_t v = queue[head];
+        if (depth[v] > 0)
+        {
+            depthSum += depth[v];
+            routed++;
+            metrics.maxDepth = std::max(metrics.maxDepth, depth[v]);
+        }
+        for (uint32_t e = in.offsets[v]; e < in.offsets[v + 1]; ++e)
+        {
+            uint32_t w = in.targets[e];
+            if (depth[w] == UINT32_MAX)
+            {
+                depth[w] = depth[v] + 1;
+                queue.push_back(w);
+            }
+        }
+    }
+    metrics.avgDepth = routed > 0 ? double(depthSum) / routed : 0;
+
+    // Partitions of the neighbor graph
+    std::vector<bool> sinkComponent(nodeCount, false);
+    for (uint32_t sink : sinks)
+    {
+        if (sink < nodeCount)
+            sinkComponent[Find(parent, sink)] = true;
+    }
+    for (uint32_t v = 0; v < nodeCount; ++v)
+    {
+        uint32_t root = Find(parent, v);
+        if (root == v)
+            metrics.partitions++;
+        if (!sinkComponent[root])
+            metrics.disconnected++;
+        if (depth[v] == UINT32_MAX)
+        {
+            metrics.unrouted++;
+            if (sinkComponent[root])
+                metrics.unroutedConnected++;
+        }
+    }
+    return metrics;
+}
+
+bool
+LraDagSnapshotWriter::Open(const std::string& filename,
+                           const std::vector<uint32_t>& addresses,
+                           const std::vector<uint32_t>& sinks)
+{
+    m_file.open(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!m_file)
+        return false;
+
+    LraDagFileHeader header;
+    std::memcpy(header.magic, LRA_DAG_MAGIC, sizeof(header.magic));
+    header.version = LRA_DAG_VERSION;
+    header.nodeCount = addresses.size();
+    header.sinkCount = sinks.size();
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    m_file.write(reinterpret_cast<const char*>(addresses.data()),
+                 addresses.size() * sizeof(uint32_t));
+    m_file.write(reinterpret_cast<const char*>(sinks.data()), sinks.size() * sizeof(uint32_t));
+    return true;
+}
+
+bool
+LraDagSnapshotWriter::IsOpen() const
+{
+    return m_file.is_open();
+}
+
+void
+LraDagSnapshotWriter::Write(const LraDagSnapshot& snapshot)
+{
+    if (!m_file.is_open())
+        return;
+    uint32_t count = snapshot.edges.size();
+    m_file.write(reinterpret_cast<const char*>(&snapshot.timeNs), sizeof(snapshot.timeNs));
+    m_file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    m_file.write(reinterpret_cast<const char*>(snapshot.edges.data()),
+                 count * sizeof(LraDagEdge));
+}
+
+void
+LraDagSnapshotWriter::Close()
+{
+    if (m_file.is_open())
+        m_file.close();
+}
+
+bool
+LraDagSnapshotReader::Open(const std::string& filename)
+{
+    m_file.open(filename, std::ios::in | std::ios::binary);
+    LraDagFileHeader header;
+    if (!m_file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, LRA_DAG_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != LRA_DAG_VERSION)
+    {
+        return false;
+    }
+    addresses.resize(header.nodeCount);
+    sinks.resize(header.sinkCount);
+    m_file.read(reinterpret_cast<char*>(addresses.data()), addresses.size() * sizeof(uint32_t));
+    m_file.read(reinterpret_cast<char*>(sinks.data()), sinks.size() * sizeof(uint32_t));
+    return static_cast<bool>(m_file);
+}
+
+bool
+LraDagSnapshotReader::Next(LraDagSnapshot& snapshot)
+{
+    uint32_t count = 0;
+    if (!m_file.read(reinterpret_cast<char*>(&snapshot.timeNs), sizeof(snapshot.timeNs)) ||
+        !m_file.read(reinterpret_cast<char*>(&count), sizeof(count)))
+    {
+        return false;
+    }
+    snapshot.edges.resize(count);
+    return static_cast<bool>(
+        m_file.read(reinterpret_cast<char*>(snapshot.edges.data()), count * sizeof(LraDagEdge)));
+}
+
+} // namespace ns3
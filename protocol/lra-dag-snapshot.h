@@ -0,0 +1,117 @@
+#ifndef LRA_DAG_SNAPSHOT_H
+#define LRA_DAG_SNAPSHOT_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/*
+ * Snapshots of the global LRA link graph and their analysis.
+ * Kept free of ns-3 includes so that tools/ can be built with a plain compiler.
+ *
+ * A snapshot file is a LraDagFileHeader, the node address table (nodeCount
+ * uint32), the sink index table (sinkCount uint32), then any number of
+ * snapshots: int64 time (ns), uint32 edge count, edges. All in host byte order.
+ */
+
+namespace ns3 {
+
+static const char LRA_DAG_MAGIC[8] = {'L', 'R', 'A', 'D', 'A', 'G', 'S', 'N'};
+static const uint32_t LRA_DAG_VERSION = 1;
+
+struct LraDagFileHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t nodeCount;
+  uint32_t sinkCount;
+};
+
+/// Link as seen by node "from": state 1 means from forwards to "to"
+struct LraDagEdge
+{
+  uint32_t from; ///< Node index
+  uint32_t to; ///< Node index
+  int32_t state; ///< -1 = unknown, 0 = incoming, 1 = outgoing
+};
+
+/// Global link graph at one instant
+struct LraDagSnapshot
+{
+  int64_t timeNs;
+  std::vector<LraDagEdge> edges;
+};
+
+/// Properties of one snapshot
+struct LraDagMetrics
+{
+  uint32_t cycles = 0; ///< Strongly connected components of outgoing links with more than one node
+  uint32_t nodesInCycles = 0; ///< Nodes belonging to those components
+  uint32_t unrouted = 0; ///< Nodes without a directed path to a sink
+  uint32_t unroutedConnected = 0; ///< Unrouted nodes that are still connected to a sink
+  uint32_t partitions = 0; ///< Connected components of the neighbor graph
+  uint32_t disconnected = 0; ///< Nodes in components without a sink
+  uint32_t maxDepth = 0; ///< Longest shortest path to a sink, in hops
+  double avgDepth = 0; ///< Average shortest path to a sink over routed non-sink nodes
+
+  /// A snapshot is converged when it is loop-free and every node connected to a sink has a route
+  bool IsConverged () const { return cycles == 0 && unroutedConnected == 0; }
+};
+
+/**
+ * Compute the metrics of a link graph.
+ * \param nodeCount number of nodes, edges refer to indices below it
+ * \param sinks indices of the sink nodes
+ * \param edges the links as seen by each node
+ * \return the snapshot metrics
+ */
+LraDagMetrics AnalyzeDag (uint32_t nodeCount, const std::vector<uint32_t> &sinks,
+                          const std::vector<LraDagEdge> &edges);
+
+/// Writes a snapshot file
+class LraDagSnapshotWriter
+{
+public:
+  /**
+   * Create the file and write header and tables.
+   * \return true if the file could be opened
+   */
+  bool Open (const std::string &filename, const std::vector<uint32_t> &addresses,
+             const std::vector<uint32_t> &sinks);
+  /** \return true if a file is open */
+  bool IsOpen () const;
+  /** Append a snapshot */
+  void Write (const LraDagSnapshot &snapshot);
+  /** Close the file */
+  void Close ();
+
+private:
+  std::ofstream m_file;
+};
+
+/// Reads a snapshot file
+class LraDagSnapshotReader
+{
+public:
+  /**
+   * Open the file and read header and tables.
+   * \return true if the file is a valid snapshot file
+   */
+  bool Open (const std::string &filename);
+  /**
+   * Read the next snapshot.
+   * \return false at end of file
+   */
+  bool Next (LraDagSnapshot &snapshot);
+
+  std::vector<uint32_t> addresses; ///< Node addresses, by node index
+  std::vector<uint32_t> sinks; ///< Sink node indices
+
+private:
+  std::ifstream m_file;
+};
+
+} // namespace ns3
+
+#endif /* LRA_DAG_SNAPSHOT_H */
@@ -0,0 +1,313 @@
+#include "lra-grid-spectrum-channel.h"
+
+#include "ns3/angles.h"
+#include "ns3/antenna-model.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+#include "ns3/net-device.h"
+#include "ns3/node.h"
+#include "ns3/propagation-delay-model.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/simulator.h"
+#include "ns3/spectrum-propagation-loss-model.h"
+#include "ns3/spectrum-signal-parameters.h"
+#include "ns3/spectrum-transmit-filter.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("LraGridSpectrumChannel");
+NS_OBJECT_ENSURE_REGISTERED(LraGridSpectrumChannel);
+
+TypeId
+LraGridSpectrumChannel::GetTypeId(void)
+{
+    static TypeId tid =
+        TypeId("ns3::LraGridSpectrumChannel")
+            .SetParent<SpectrumChannel>()
+            .AddConstructor<LraGridSpectrumChannel>()
+            .AddAttribute("MaxRange",
+                          "Distance (m) beyond which receivers are skipped. "
+                          "0 derives it from the propagation loss model and MaxLossDb.",
+                          DoubleValue(0.0),
+                          MakeDoubleAccessor(&LraGridSpectrumChannel::m_maxRange),
+                          MakeDoubleChecker<double>(0.0));
+    return tid;
+}
+
+LraGridSpectrumChannel::LraGridSpectrumChannel()
+    : m_range(-1)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+LraGridSpectrumChannel::~LraGridSpectrumChannel()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+LraGridSpectrumChannel::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    m_phyList.clear();
+    SpectrumChannel::DoDispose();
+}
+
+void
+LraGridSpectrumChannel::AddRx(Ptr<SpectrumPhy> phy)
+{
+    NS_LOG_FUNCTION(this << phy);
+
+    if (std::find(m_phyList.begin(), m_phyList.end(), phy) != m_phyList.end())
+        return;
+
+    // Reuse a slot freed by RemoveRx if any, PHYs switching channel come and go
+    auto freeSlot = std::find(m_phyList.begin(), m_phyList.end(), nullptr);
+    uint32_t slot = freeSlot - m_phyList.begin();
+    if (freeSlot == m_phyList.end())
+    {
+        m_phyList.push_back(phy);
+    }
+    else
+    {
+        *freeSlot = phy;
+    }
+    // Mobility is usually not reachable yet, place it at the first transmission
+    m_pending.push_back(slot);
+}
+
+void
+LraGridSpectrumChannel::RemoveRx(Ptr<SpectrumPhy> phy)
+{
+    NS_LOG_FUNCTION(this << phy);
+
+    auto it = std::find(m_phyList.begin(), m_phyList.end(), phy);
+    if (it == m_phyList.end())
+        return;
+
+    uint32_t slot = it - m_phyList.begin();
+    m_grid.Remove(slot);
+    m_pending.erase(std::remove(m_pending.begin(), m_pending.end(), slot), m_pending.end());
+    m_unlocated.erase(std::remove(m_unlocated.begin(), m_unlocated.end(), slot),
+                      m_unlocated.end());
+    *it = nullptr;
+}
+
+std::size_t
+LraGridSpectrumChannel::GetNDevices() const
+{
+    return std::count_if(m_phyList.begin(), m_phyList.end(), [](Ptr<SpectrumPhy> phy) {
+        return phy != nullptr;
+    });
+}
+
+Ptr<NetDevice>
+LraGridSpectrumChannel::GetDevice(std::size_t i) const
+{
+    for (auto phy : m_phyList)
+    {
+        if (phy == nullptr)
+            continue;
+        if (i == 0)
+            return phy->GetDevice();
+        i--;
+    }
+    NS_FATAL_ERROR("Device index out of range");
+    return nullptr;
+}
+
+double
+LraGridSpectrumChannel::GetRange()
+{
+    if (m_range < 0)
+    {
+        m_range = m_maxRange > 0 ? m_maxRange : ComputeRange();
+        NS_LOG_INFO("Channel range " << m_range << " m");
+        if (std::isfinite(m_range))
+        {
+            m_grid.SetCellSize(m_range, m_range / 4);
+        }
+    }
+    return m_range;
+}
+
+double
+LraGridSpectrumChannel::ComputeRange() const
+{
+    if (!m_propagationLoss)
+        return std::numeric_limits<double>::infinity();
+
+    Ptr<ConstantPositionMobilityModel> a = CreateObject<ConstantPositionMobilityModel>();
+    Ptr<ConstantPositionMobilityModel> b = CreateObject<ConstantPositionMobilityModel>();
+    auto lossAt = [&](double distance) {
+        b->SetPosition(Vector(distance, 0, 0));
+        return -m_propagationLoss->CalcRxPower(0, a, b);
+    };
+
+    // Grow an upper bound, then bisect on the MaxLossDb crossing
+    double lo = 0;
+    double hi = 1;
+    while (lossAt(hi) <= m_maxLossDb)
+    {
+        lo = hi;
+        hi *= 2;
+        if (hi > 1e7)
+            return std::numeric_limits<double>::infinity();
+    }
+    for (int i = 0; i < 60; ++i)
+    {
+        double mid = (lo + hi) / 2;
+        if (lossAt(mid) <= m_maxLossDb)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return hi;
+}
+
+void
+LraGridSpectrumChannel::IndexPhys()
+{
+    if (m_pending.empty())
+        return;
+
+    GetRange();
+    std::vector<uint32_t> stillPending;
+    for (uint32_t slot : m_pending)
+    {
+        Ptr<MobilityModel> mobility = m_phyList[slot]->GetMobility();
+        if (mobility)
+        {
+            m_grid.Add(slot, mobility);
+        }
+        else if (m_phyList[slot]->GetDevice())
+        {
+            // No mobility at all: treat it like the default channel does, always in range
+            m_unlocated.push_back(slot);
+        }
+        else
+        {
+            stillPending.push_back(slot);
+        }
+    }
+    m_pending.swap(stillPending);
+}
+
+void
+LraGridSpectrumChannel::StartTx(Ptr<SpectrumSignalParameters> txParams)
+{
+    NS_LOG_FUNCTION(this << txParams->psd << txParams->duration << txParams->txPhy);
+    NS_ASSERT_MSG(txParams->psd, "NULL txPsd");
+    NS_ASSERT_MSG(txParams->txPhy, "NULL txPhy");
+
+    Ptr<SpectrumSignalParameters> txParamsTrace = txParams->Copy();
+    txParamsTrace->txPhy = nullptr;
+    m_txSigParamsTrace(txParamsTrace);
+
+    IndexPhys();
+    Ptr<MobilityModel> senderMobility = txParams->txPhy->GetMobility();
+
+    auto evaluate = [&](uint32_t slot) {
+        Ptr<SpectrumPhy> rxPhy = m_phyList[slot];
+        if (rxPhy == nullptr || rxPhy == txParams->txPhy)
+            return;
+        if (m_filter && m_filter->Filter(txParams, rxPhy))
+            return;
+
+        Time delay = MicroSeconds(0);
+        Ptr<MobilityModel> receiverMobility = rxPhy->GetMobility();
+        Ptr<SpectrumSignalParameters> rxParams = txParams->Copy();
+        if (senderMobility && receiverMobility)
+        {
+            double txAntennaGain = 0;
+            double rxAntennaGain = 0;
+            double propagationGainDb = 0;
+            double pathLossDb = 0;
+            if (rxParams->txAntenna)
+            {
+                Angles txAngles(receiverMobility->GetPosition(), senderMobility->GetPosition());
+                txAntennaGain = rxParams->txAntenna->GetGainDb(txAngles);
+                pathLossDb -= txAntennaGain;
+            }
+            Ptr<AntennaModel> rxAntenna = DynamicCast<AntennaModel>(rxPhy->GetAntenna());
+            if (rxAntenna)
+            {
+                Angles rxAngles(senderMobility->GetPosition(), receiverMobility->GetPosition());
+                rxAntennaGain = rxAntenna->GetGainDb(rxAngles);
+                pathLossDb -= rxAntennaGain;
+            }
+            if (m_propagationLoss)
+            {
+                propagationGainDb =
+                    m_propagationLoss->CalcRxPower(0, senderMobility, receiverMobility);
+                pathLossDb -= propagationGainDb;
+            }
+            m_gainTrace(senderMobility,
+                        receiverMobility,
+                        txAntennaGain,
+                        rxAntennaGain,
+                        propagationGainDb,
+                        pathLossDb);
+            m_pathLossTrace(txParams->txPhy, rxPhy, pathLossDb);
+            if (pathLossDb > m_maxLossDb)
+                return; // beyond range
+
+            double pathGainLinear = std::pow(10.0, (-pathLossDb) / 10.0);
+            *(rxParams->psd) *= pathGainLinear;
+
+            if (m_spectrumPropagationLoss)
+            {
+                rxParams->psd = m_spectrumPropagationLoss->CalcRxPowerSpectralDensity(
+                    rxParams,
+                    senderMobility,
+                    receiverMobility);
+            }
+            if (m_propagationDelay)
+            {
+                delay = m_propagationDelay->GetDelay(senderMobility, receiverMobility);
+            }
+        }
+
+        Ptr<NetDevice> netDev = rxPhy->GetDevice();
+        if (netDev)
+        {
+            Simulator::ScheduleWithContext(netDev->GetNode()->GetId(),
+                                           delay,
+                                           &LraGridSpectrumChannel::StartRx,
+                                           this,
+                                           rxParams,
+                                           rxPhy);
+        }
+        else
+        {
+            Simulator::Schedule(delay, &LraGridSpectrumChannel::StartRx, this, rxParams, rxPhy);
+        }
+    };
+
+    if (senderMobility)
+    {
+        m_grid.ForEachCandidate(senderMobility->GetPosition(), GetRange(), evaluate);
+        std::for_each(m_unlocated.begin(), m_unlocated.end(), evaluate);
+    }
+    else
+    {
+        for (uint32_t slot = 0; slot < m_phyList.size(); ++slot)
+        {
+            evaluate(slot);
+        }
+    }
+}
+
+void
+LraGridSpectrumChannel::StartRx(Ptr<SpectrumSignalParameters> params, Ptr<SpectrumPhy> receiver)
+{
+    NS_LOG_FUNCTION(this << params);
+    receiver->StartRx(params);
+}
+
+} // namespace ns3
@@ -0,0 +1,67 @@
+#ifndef LRA_GRID_SPECTRUM_CHANNEL_H
+#define LRA_GRID_SPECTRUM_CHANNEL_H
+
+#include "lra-spatial-grid.h"
+
+#include "ns3/spectrum-channel.h"
+#include "ns3/spectrum-phy.h"
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Spectrum channel that only reaches receivers in range.
+ *
+ * Behaves like SingleModelSpectrumChannel, but receivers are kept in a
+ * LraSpatialGrid and a transmission is only evaluated against the PHYs that
+ * may be within the distance where the path loss stays below MaxLossDb.
+ * Since SingleModelSpectrumChannel discards those receivers anyway, every
+ * in-range receiver gets exactly the same signal as with the default channel,
+ * while the per-transmission cost drops from O(N) to O(neighbors).
+ *
+ * The range is MaxRange when set, otherwise it is derived once from the
+ * propagation loss model, which must then be deterministic and monotonic in
+ * the distance (e.g. LogDistancePropagationLossModel). Antenna gains are
+ * assumed to be non-positive (isotropic antennas).
+ */
+class LraGridSpectrumChannel : public SpectrumChannel
+{
+public:
+  static TypeId GetTypeId (void);
+  /** Constructor */
+  LraGridSpectrumChannel ();
+  /** Destructor */
+  virtual ~LraGridSpectrumChannel ();
+
+  // Inherited
+  virtual void AddRx (Ptr<SpectrumPhy> phy);
+  virtual void RemoveRx (Ptr<SpectrumPhy> phy);
+  virtual void StartTx (Ptr<SpectrumSignalParameters> params);
+  virtual std::size_t GetNDevices () const;
+  virtual Ptr<NetDevice> GetDevice (std::size_t i) const;
+
+  /** \return the distance beyond which receivers are never evaluated (m) */
+  double GetRange ();
+
+protected:
+  virtual void DoDispose ();
+
+private:
+  /// Hand the signal to the receiver PHY
+  void StartRx (Ptr<SpectrumSignalParameters> params, Ptr<SpectrumPhy> receiver);
+  /// Put in the grid every PHY whose mobility is known
+  void IndexPhys ();
+  /// Find the distance at which the path loss exceeds MaxLossDb
+  double ComputeRange () const;
+
+  std::vector<Ptr<SpectrumPhy>> m_phyList; // Receivers, nullptr marks a removed slot
+  std::vector<uint32_t> m_pending; // Slots not yet placed in m_grid
+  std::vector<uint32_t> m_unlocated; // Slots without mobility, always evaluated
+  LraSpatialGrid m_grid; // Receivers indexed by position
+  double m_maxRange; // Configured range (m), 0 to derive it
+  double m_range; // Range in use (m), negative until computed
+};
+
+} // namespace ns3
+
+#endif /* LRA_GRID_SPECTRUM_CHANNEL_H */
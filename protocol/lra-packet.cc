@@ -0,0 +1,521 @@
+#include "lra-packet.h"
+
+#include "ns3/packet.h"
+
+#include <cstring>
+
+namespace ns3
+{
+
+NS_OBJECT_ENSURE_REGISTERED(LraHeader);
+NS_OBJECT_ENSURE_REGISTERED(LraDiscoveryHeader);
+NS_OBJECT_ENSURE_REGISTERED(LraAggregateHeader);
+NS_OBJECT_ENSURE_REGISTERED(LraReferenceLevelHeader);
+NS_OBJECT_ENSURE_REGISTERED(LraPreviousHopTag);
+
+/// Type octet flag of a header carrying the sender mobility
+static const uint8_t LRA_MOBILITY_FLAG = 0x80;
+
+static void
+WriteFloat(Buffer::Iterator& i, float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    i.WriteHtonU32(bits);
+}
+
+static float
+ReadFloat(Buffer::Iterator& i)
+{
+    uint32_t bits = i.ReadNtohU32();
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+LraHeader::LraHeader(LraMessageType type, uint32_t sequence)
+    : m_type(type),
+      m_sequence(sequence),
+      m_congestion(0),
+      m_energy(255),
+      m_hasMobility(false),
+      m_position{0, 0},
+      m_velocity{0, 0},
+      m_valid(true)
+{
+}
+
+TypeId
+LraHeader::GetTypeId(void)
+{
+    static TypeId tid = TypeId("ns3::LraHeader")
+                            .SetParent<Header>()
+                            .AddConstructor<LraHeader>();
+    return tid;
+}
+
+TypeId
+LraHeader::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+uint32_t
+LraHeader::GetSerializedSize() const
+{
+    return m_hasMobility ? 23 : 7;
+}
+
+void
+LraHeader::Serialize(Buffer::Iterator i) const
+{
+    i.WriteU8(static_cast<uint8_t>(m_type) | (m_hasMobility ? LRA_MOBILITY_FLAG : 0));
+    i.WriteHtonU32(m_sequence);
+    i.WriteU8(m_congestion);
+    i.WriteU8(m_energy);
+    if (m_hasMobility)
+    {
+        WriteFloat(i, m_position[0]);
+        WriteFloat(i, m_position[1]);
+        WriteFloat(i, m_velocity[0]);
+        WriteFloat(i, m_velocity[1]);
+    }
+}
+
+uint32_t
+LraHeader::Deserialize(Buffer::Iterator start)
+{
+    Buffer::Iterator i = start;
+    uint8_t type = i.ReadU8();
+    m_hasMobility = (type & LRA_MOBILITY_FLAG) != 0;
+    type &= ~LRA_MOBILITY_FLAG;
+    m_valid = (type >= LRA_ACK_REQUEST && type <= LRA_REJOIN_RESPONSE);
+    m_type = static_cast<LraMessageType>(type);
+    m_sequence = i.ReadNtohU32();
+    m_congestion = i.ReadU8();
+    m_energy = i.ReadU8();
+    if (m_hasMobility)
+    {
+        m_position[0] = ReadFloat(i);
+        m_position[1] = ReadFloat(i);
+        m_velocity[0] = ReadFloat(i);
+        m_velocity[1] = ReadFloat(i);
+    }
+
+    uint32_t dist = i.GetDistanceFrom(start);
+    NS_ASSERT(dist == GetSerializedSize());
+    return dist;
+}
+
+void
+LraHeader::Print(std::ostream& os) const
+{
+    switch (m_type)
+    {
+    case LRA_ACK_REQUEST:
+        os << "ACK_REQUEST";
+        break;
+    case LRA_ACK_RESPONSE:
+        os << "ACK_RESPONSE";
+        break;
+    case LRA_HELLO:
+        os << "HELLO";
+        break;
+    case LRA_HELLO_RESPONSE:
+        os << "HELLO_RESPONSE";
+        break;
+    case LRA_REVERSAL:
+        os << "REVERSAL";
+        break;
+    case LRA_DISCOVERY:
+        os << "DISCOVERY";
+        break;
+    case LRA_AGGREGATE:
+        os << "AGGREGATE";
+        break;
+    case LRA_PARTITION:
+        os << "PARTITION";
+        break;
+    case LRA_REJOIN:
+        os << "REJOIN";
+        break;
+    case LRA_REJOIN_RESPONSE:
+        os << "REJOIN_RESPONSE";
+        break;
+    default:
+        os << "UNKNOWN_TYPE";
+    }
+    os << " seq " << m_sequence << " congestion " << int(m_congestion)
+       << " energy " << int(m_energy);
+    if (m_hasMobility)
+    {
+        os << " position " << GetPosition() << " velocity " << GetVelocity();
+    }
+}
+
+void
+LraHeader::SetType(LraMessageType type)
+{
+    m_type = type;
+}
+
+LraMessageType
+LraHeader::GetType() const
+{
+    return m_type;
+}
+
+void
+LraHeader::SetSequence(uint32_t sequence)
+{
+    m_sequence = sequence;
+}
+
+uint32_t
+LraHeader::GetSequence() const
+{
+    return m_sequence;
+}
+
+void
+LraHeader::SetCongestion(uint8_t congestion)
+{
+    m_congestion = congestion;
+}
+
+uint8_t
+LraHeader::GetCongestion() const
+{
+    return m_congestion;
+}
+
+void
+LraHeader::SetEnergy(uint8_t energy)
+{
+    m_energy = energy;
+}
+
+uint8_t
+LraHeader::GetEnergy() const
+{
+    return m_energy;
+}
+
+void
+LraHeader::SetMobility(const Vector& position, const Vector& velocity)
+{
+    m_hasMobility = true;
+    m_position[0] = position.x;
+    m_position[1] = position.y;
+    m_velocity[0] = velocity.x;
+    m_velocity[1] = velocity.y;
+}
+
+bool
+LraHeader::HasMobility() const
+{
+    return m_hasMobility;
+}
+
+Vector
+LraHeader::GetPosition() const
+{
+    return Vector(m_position[0], m_position[1], 0);
+}
+
+Vector
+LraHeader::GetVelocity() const
+{
+    return Vector(m_velocity[0], m_velocity[1], 0);
+}
+
+bool
+LraHeader::IsValid() const
+{
+    return m_valid;
+}
+
+std::ostream&
+operator<<(std::ostream& os, const LraHeader& h)
+{
+    h.Print(os);
+    return os;
+}
+
+LraDiscoveryHeader::LraDiscoveryHeader()
+{
+}
+
+TypeId
+LraDiscoveryHeader::GetTypeId(void)
+{
+    static TypeId tid = TypeId("ns3::LraDiscoveryHeader")
+                            .SetParent<Header>()
+                            .AddConstructor<LraDiscoveryHeader>();
+    return tid;
+}
+
+TypeId
+LraDiscoveryHeader::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+uint32_t
+LraDiscoveryHeader::GetSerializedSize() const
+{
+    return 2 + m_links.size() * 5;
+}
+
+void
+LraDiscoveryHeader::Serialize(Buffer::Iterator i) const
+{
+    i.WriteHtonU16(m_links.size());
+    for (const auto& link : m_links)
+    {
+        i.WriteHtonU32(link.first.Get());
+        i.WriteU8(static_cast<uint8_t>(link.second));
+    }
+}
+
+uint32_t
+LraDiscoveryHeader::Deserialize(Buffer::Iterator start)
+{
+    Buffer::Iterator i = start;
+    uint16_t count = i.ReadNtohU16();
+    m_links.clear();
+    m_links.reserve(count);
+    for (uint16_t n = 0; n < count; ++n)
+    {
+        Ipv4Address neighbor(i.ReadNtohU32());
+        int8_t state = static_cast<int8_t>(i.ReadU8());
+        m_links.emplace_back(neighbor, state);
+    }
+
+    uint32_t dist = i.GetDistanceFrom(start);
+    NS_ASSERT(dist == GetSerializedSize());
+    return dist;
+}
+
+void
+LraDiscoveryHeader::Print(std::ostream& os) const
+{
+    os << m_links.size() << " links:";
+    for (const auto& link : m_links)
+    {
+        os << " " << link.first << "(" << int(link.second) << ")";
+    }
+}
+
+bool
+LraDiscoveryHeader::AddLink(Ipv4Address neighbor, int state)
+{
+    if (m_links.size() >= MAX_LINKS)
+    {
+        return false;
+    }
+    m_links.emplace_back(neighbor, static_cast<int8_t>(state));
+    return true;
+}
+
+const std::vector<std::pair<Ipv4Address, int8_t>>&
+LraDiscoveryHeader::GetLinks() const
+{
+    return m_links;
+}
+
+LraAggregateHeader::LraAggregateHeader()
+{
+}
+
+TypeId
+LraAggregateHeader::GetTypeId(void)
+{
+    static TypeId tid = TypeId("ns3::LraAggregateHeader")
+                            .SetParent<Header>()
+                            .AddConstructor<LraAggregateHeader>();
+    return tid;
+}
+
+TypeId
+LraAggregateHeader::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+uint32_t
+LraAggregateHeader::GetSerializedSize() const
+{
+    return 2 + m_lengths.size() * 2;
+}
+
+void
+LraAggregateHeader::Serialize(Buffer::Iterator i) const
+{
+    i.WriteHtonU16(m_lengths.size());
+    for (uint16_t length : m_lengths)
+    {
+        i.WriteHtonU16(length);
+    }
+}
+
+uint32_t
+LraAggregateHeader::Deserialize(Buffer::Iterator start)
+{
+    Buffer::Iterator i = start;
+    uint16_t count = i.ReadNtohU16();
+    m_lengths.resize(count);
+    for (auto& length : m_lengths)
+    {
+        length = i.ReadNtohU16();
+    }
+
+    uint32_t dist = i.GetDistanceFrom(start);
+    NS_ASSERT(dist == GetSerializedSize());
+    return dist;
+}
+
+void
+LraAggregateHeader::Print(std::ostream& os) const
+{
+    os << m_lengths.size() << " datagrams";
+}
+
+void
+LraAggregateHeader::AddLength(uint16_t length)
+{
+    m_lengths.push_back(length);
+}
+
+const std::vector<uint16_t>&
+LraAggregateHeader::GetLengths() const
+{
+    return m_lengths;
+}
+
+LraReferenceLevelHeader::LraReferenceLevelHeader(uint32_t tick,
+                                                 Ipv4Address origin,
+                                                 bool reflected)
+    : m_tick(tick),
+      m_origin(origin),
+      m_reflected(reflected)
+{
+}
+
+TypeId
+LraReferenceLevelHeader::GetTypeId(void)
+{
+    static TypeId tid = TypeId("ns3::LraReferenceLevelHeader")
+                            .SetParent<Header>()
+                            .AddConstructor<LraReferenceLevelHeader>();
+    return tid;
+}
+
+TypeId
+LraReferenceLevelHeader::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+uint32_t
+LraReferenceLevelHeader::GetSerializedSize() const
+{
+    return 9;
+}
+
+void
+LraReferenceLevelHeader::Serialize(Buffer::Iterator i) const
+{
+    i.WriteHtonU32(m_tick);
+    i.WriteHtonU32(m_origin.Get());
+    i.WriteU8(m_reflected ? 1 : 0);
+}
+
+uint32_t
+LraReferenceLevelHeader::Deserialize(Buffer::Iterator start)
+{
+    Buffer::Iterator i = start;
+    m_tick = i.ReadNtohU32();
+    m_origin = Ipv4Address(i.ReadNtohU32());
+    m_reflected = i.ReadU8() != 0;
+
+    uint32_t dist = i.GetDistanceFrom(start);
+    NS_ASSERT(dist == GetSerializedSize());
+    return dist;
+}
+
+void
+LraReferenceLevelHeader::Print(std::ostream& os) const
+{
+    os << "level (" << m_tick << ", " << m_origin << (m_reflected ? ", reflected)" : ")");
+}
+
+uint32_t
+LraReferenceLevelHeader::GetTick() const
+{
+    return m_tick;
+}
+
+Ipv4Address
+LraReferenceLevelHeader::GetOrigin() const
+{
+    return m_origin;
+}
+
+bool
+LraReferenceLevelHeader::IsReflected() const
+{
+    return m_reflected;
+}
+
+LraPreviousHopTag::LraPreviousHopTag(Ipv4Address previousHop)
+    : m_previousHop(previousHop)
+{
+}
+
+TypeId
+LraPreviousHopTag::GetTypeId(void)
+{
+    static TypeId tid = TypeId("ns3::LraPreviousHopTag")
+                            .SetParent<Tag>()
+                            .AddConstructor<LraPreviousHopTag>();
+    return tid;
+}
+
+TypeId
+LraPreviousHopTag::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+uint32_t
+LraPreviousHopTag::GetSerializedSize() const
+{
+    return 4;
+}
+
+void
+LraPreviousHopTag::Serialize(TagBuffer i) const
+{
+    i.WriteU32(m_previousHop.Get());
+}
+
+void
+LraPreviousHopTag::Deserialize(TagBuffer i)
+{
+    m_previousHop = Ipv4Address(i.ReadU32());
+}
+
+void
+LraPreviousHopTag::Print(std::ostream& os) const
+{
+    os << "previousHop=" << m_previousHop;
+}
+
+Ipv4Address
+LraPreviousHopTag::GetPreviousHop() const
+{
+    return m_previousHop;
+}
+
+} // namespace ns3
@@ -0,0 +1,264 @@
+#ifndef LRA_PACKET_H
+#define LRA_PACKET_H
+
+#include "ns3/header.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/tag.h"
+#include "ns3/vector.h"
+#include <iostream>
+#include <utility>
+#include <vector>
+
+namespace ns3 {
+
+/// Kind of LRA control message
+enum LraMessageType{
+  LRA_ACK_REQUEST = 1, ///< Probe of a next hop
+  LRA_ACK_RESPONSE = 2, ///< Answer to a probe
+  LRA_HELLO = 3, ///< Neighbor discovery broadcast
+  LRA_HELLO_RESPONSE = 4, ///< Answer to a hello
+  LRA_REVERSAL = 5, ///< The sender reversed its links, followed by LraReferenceLevelHeader
+  LRA_DISCOVERY = 6, ///< Aggregated neighbor discovery broadcast, followed by LraDiscoveryHeader
+  LRA_AGGREGATE = 7, ///< Data packets bound for the sink, followed by LraAggregateHeader
+  LRA_PARTITION = 8, ///< The sender is cut off from the sink, followed by LraReferenceLevelHeader
+  LRA_REJOIN = 9, ///< Probe of a partitioned node for a neighbor connected to the sink
+  LRA_REJOIN_RESPONSE = 10 ///< Answer of a connected neighbor to a rejoin probe
+};
+
+/**
+ * \brief Header of every LRA control message.
+ *
+ * \verbatim
+   0                   1                   2                   3
+   0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |M|    Type     |              Sequence number ...
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+         ...      |  Congestion   |    Energy     |  Position X ...
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+         ...      |  Position Y, Velocity X, Velocity Y (M only) ...
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  \endverbatim
+ *
+ * The sequence number is incremented by the sender for every control message,
+ * so (origin, sequence) identifies a message. Congestion is the occupancy of
+ * the sender's transmission queue, 0 (empty) to 255 (full). Energy is the
+ * remaining fraction of the sender's battery, 0 (empty) to 255 (full or mains).
+ * When the M bit is set the header ends with the 2D position (m) and velocity
+ * (m/s) of the sender, as four IEEE 754 single precision numbers.
+ */
+class LraHeader : public Header
+{
+public:
+  /**
+   * Constructor
+   * \param type the message type
+   * \param sequence the sender sequence number
+   */
+  LraHeader (LraMessageType type = LRA_HELLO, uint32_t sequence = 0);
+
+  static TypeId GetTypeId (void);
+  // Inherited
+  TypeId GetInstanceTypeId () const;
+  uint32_t GetSerializedSize () const;
+  void Serialize (Buffer::Iterator start) const;
+  uint32_t Deserialize (Buffer::Iterator start);
+  void Print (std::ostream &os) const;
+
+  void SetType (LraMessageType type);
+  LraMessageType GetType () const;
+  void SetSequence (uint32_t sequence);
+  uint32_t GetSequence () const;
+  void SetCongestion (uint8_t congestion);
+  uint8_t GetCongestion () const;
+  void SetEnergy (uint8_t energy);
+  uint8_t GetEnergy () const;
+  /// Attach the sender position (m) and velocity (m/s), z is not carried
+  void SetMobility (const Vector &position, const Vector &velocity);
+  /** \return true if the header carries the sender position and velocity */
+  bool HasMobility () const;
+  Vector GetPosition () const;
+  Vector GetVelocity () const;
+  /** \return true if the type field holds a known message type */
+  bool IsValid () const;
+
+private:
+  LraMessageType m_type; // Message type
+  uint32_t m_sequence; // Sender sequence number
+  uint8_t m_congestion; // Sender queue occupancy
+  uint8_t m_energy; // Sender remaining energy
+  bool m_hasMobility; // Position and velocity are carried
+  float m_position[2]; // Sender position (m)
+  float m_velocity[2]; // Sender velocity (m/s)
+  bool m_valid; // Deserialized type was known
+};
+
+std::ostream &operator<< (std::ostream &os, const LraHeader &h);
+
+/**
+ * \brief Body of an aggregated discovery message.
+ *
+ * Lists every neighbor known by the sender together with the orientation the
+ * sender gives to the link (1 = the sender forwards to it, 0 = the neighbor
+ * forwards to the sender, -1 = not decided yet).
+ *
+ * \verbatim
+   0                   1                   2                   3
+   0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |         Link count            |  Neighbor address ...
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+        ...                       |     State     |  ...
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  \endverbatim
+ */
+class LraDiscoveryHeader : public Header
+{
+public:
+  /// Links that fit a 1500 bytes frame together with the IP and LRA headers
+  static const uint16_t MAX_LINKS = 280;
+
+  LraDiscoveryHeader ();
+
+  static TypeId GetTypeId (void);
+  // Inherited
+  TypeId GetInstanceTypeId () const;
+  uint32_t GetSerializedSize () const;
+  void Serialize (Buffer::Iterator start) const;
+  uint32_t Deserialize (Buffer::Iterator start);
+  void Print (std::ostream &os) const;
+
+  /**
+   * Add a link claim, ignored once MAX_LINKS claims are stored.
+   * \return false if the header is full
+   */
+  bool AddLink (Ipv4Address neighbor, int state);
+  /// \return the link claims of the sender
+  const std::vector<std::pair<Ipv4Address, int8_t>> &GetLinks () const;
+
+private:
+  std::vector<std::pair<Ipv4Address, int8_t>> m_links; // Neighbor and link state claimed by the sender
+};
+
+/**
+ * \brief Body of an aggregate frame.
+ *
+ * Lists the length of every inner IPv4 datagram (IP header included); the
+ * datagrams follow back to back in the same order.
+ *
+ * \verbatim
+   0                   1                   2                   3
+   0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |        Datagram count         |      Length of datagram 1     |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |              ...              |  Datagrams ...
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  \endverbatim
+ */
+class LraAggregateHeader : public Header
+{
+public:
+  LraAggregateHeader ();
+
+  static TypeId GetTypeId (void);
+  // Inherited
+  TypeId GetInstanceTypeId () const;
+  uint32_t GetSerializedSize () const;
+  void Serialize (Buffer::Iterator start) const;
+  uint32_t Deserialize (Buffer::Iterator start);
+  void Print (std::ostream &os) const;
+
+  /// Append the length of the next datagram
+  void AddLength (uint16_t length);
+  /// \return the datagram lengths, in order
+  const std::vector<uint16_t> &GetLengths () const;
+
+private:
+  std::vector<uint16_t> m_lengths; // Length of every inner datagram
+};
+
+/**
+ * \brief Reference level of a reversal, as in TORA.
+ *
+ * Identifies the link failure a wave of reversals descends from: the timer
+ * tick of the failure and the node that lost its last outgoing link. The
+ * reflected flag is set once the wave reached the end of the component and
+ * travels back toward its origin. Levels are ordered by tick, then origin,
+ * then reflected flag.
+ *
+ * \verbatim
+   0                   1                   2                   3
+   0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                          Failure tick                         |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                            Origin                             |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |   Reflected   |
+  +-+-+-+-+-+-+-+-+
+  \endverbatim
+ */
+class LraReferenceLevelHeader : public Header
+{
+public:
+  /**
+   * Constructor
+   * \param tick timer tick of the link failure, 0 for no level
+   * \param origin node that lost its last outgoing link
+   * \param reflected the wave travels back toward its origin
+   */
+  LraReferenceLevelHeader (uint32_t tick = 0, Ipv4Address origin = Ipv4Address (),
+                           bool reflected = false);
+
+  static TypeId GetTypeId (void);
+  // Inherited
+  TypeId GetInstanceTypeId () const;
+  uint32_t GetSerializedSize () const;
+  void Serialize (Buffer::Iterator start) const;
+  uint32_t Deserialize (Buffer::Iterator start);
+  void Print (std::ostream &os) const;
+
+  uint32_t GetTick () const;
+  Ipv4Address GetOrigin () const;
+  bool IsReflected () const;
+
+private:
+  uint32_t m_tick; // Timer tick of the link failure
+  Ipv4Address m_origin; // Node that lost its last outgoing link
+  bool m_reflected; // The wave travels back toward its origin
+};
+
+/**
+ * \brief Packet tag carrying the address of the last node that forwarded a data packet.
+ *
+ * Lets every hop learn the reverse path toward the packet source. A packet
+ * without the tag comes straight from its source.
+ */
+class LraPreviousHopTag : public Tag
+{
+public:
+  /**
+   * Constructor
+   * \param previousHop address of the forwarding node
+   */
+  LraPreviousHopTag (Ipv4Address previousHop = Ipv4Address ());
+
+  static TypeId GetTypeId (void);
+  // Inherited
+  TypeId GetInstanceTypeId () const;
+  uint32_t GetSerializedSize () const;
+  void Serialize (TagBuffer i) const;
+  void Deserialize (TagBuffer i);
+  void Print (std::ostream &os) const;
+
+  /** \return the address of the forwarding node */
+  Ipv4Address GetPreviousHop () const;
+
+private:
+  Ipv4Address m_previousHop; // Last forwarding node
+};
+
+} // namespace ns3
+
+#endif /* LRA_PACKET_H */
@@ -0,0 +1,81 @@
+#include "lra-region-cut.h"
+
+#include "ns3/log.h"
+#include "ns3/mobility-model.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("LraRegionCutLossModel");
+NS_OBJECT_ENSURE_REGISTERED(LraRegionCutLossModel);
+
+TypeId
+LraRegionCutLossModel::GetTypeId(void)
+{
+    static TypeId tid = TypeId("ns3::LraRegionCutLossModel")
+                            .SetParent<PropagationLossModel>()
+                            .AddConstructor<LraRegionCutLossModel>();
+    return tid;
+}
+
+LraRegionCutLossModel::LraRegionCutLossModel()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+LraRegionCutLossModel::Cut(double x0, double y0, double x1, double y1)
+{
+    NS_LOG_FUNCTION(this << x0 << y0 << x1 << y1);
+    m_regions.push_back(Region{x0, y0, x1, y1});
+}
+
+void
+LraRegionCutLossModel::Restore(double x0, double y0, double x1, double y1)
+{
+    NS_LOG_FUNCTION(this << x0 << y0 << x1 << y1);
+    auto it = std::find_if(m_regions.begin(), m_regions.end(), [&](const Region& region) {
+        return region.x0 == x0 && region.y0 == y0 && region.x1 == x1 && region.y1 == y1;
+    });
+    if (it != m_regions.end())
+    {
+        m_regions.erase(it);
+    }
+}
+
+bool
+LraRegionCutLossModel::IsCut(const Vector& a, const Vector& b) const
+{
+    for (const auto& region : m_regions)
+    {
+        bool insideA = a.x >= region.x0 && a.x <= region.x1 && a.y >= region.y0 && a.y <= region.y1;
+        bool insideB = b.x >= region.x0 && b.x <= region.x1 && b.y >= region.y0 && b.y <= region.y1;
+        if (insideA != insideB)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+double
+LraRegionCutLossModel::DoCalcRxPower(double txPowerDbm,
+                                     Ptr<MobilityModel> a,
+                                     Ptr<MobilityModel> b) const
+{
+    if (!m_regions.empty() && IsCut(a->GetPosition(), b->GetPosition()))
+    {
+        return -1000;
+    }
+    return txPowerDbm;
+}
+
+int64_t
+LraRegionCutLossModel::DoAssignStreams(int64_t)
+{
+    return 0;
+}
+
+} // namespace ns3
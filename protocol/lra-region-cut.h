@@ -0,0 +1,51 @@
+#ifndef LRA_REGION_CUT_H
+#define LRA_REGION_CUT_H
+
+#include "ns3/propagation-loss-model.h"
+#include "ns3/vector.h"
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Propagation loss model that cuts the links crossing the border of
+ * rectangular regions.
+ *
+ * While a region is cut, a frame between a node inside it and a node outside
+ * is lost (-1000 dBm, like RangePropagationLossModel beyond its range), and
+ * the links on each side are left untouched, so the region is partitioned
+ * from the rest of the network. It is chained after the path loss model of
+ * the Wi-Fi channels and queried directly by LraUnitDiskChannel. Without an
+ * active cut the received power is passed through unchanged.
+ */
+class LraRegionCutLossModel : public PropagationLossModel
+{
+public:
+  static TypeId GetTypeId (void);
+  /** Constructor */
+  LraRegionCutLossModel ();
+
+  /// Start cutting the links across the border of the rectangle [x0, x1] x [y0, y1]
+  void Cut (double x0, double y0, double x1, double y1);
+  /// Stop one cut started by Cut with the same rectangle
+  void Restore (double x0, double y0, double x1, double y1);
+  /** \return true if a link between the two positions crosses an active cut */
+  bool IsCut (const Vector &a, const Vector &b) const;
+
+private:
+  // Inherited
+  virtual double DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a,
+                                Ptr<MobilityModel> b) const;
+  virtual int64_t DoAssignStreams (int64_t stream);
+
+  /// Rectangle whose border is cut
+  struct Region
+  {
+    double x0, y0, x1, y1;
+  };
+  std::vector<Region> m_regions; // Active cuts, the same rectangle may be cut twice
+};
+
+} // namespace ns3
+
+#endif /* LRA_REGION_CUT_H */
@@ -0,0 +1,198 @@
+#include "lra-replication.h"
+
+#include <cmath>
+#include <limits>
+
+namespace ns3
+{
+
+namespace
+{
+
+/// Quantile of the standard normal distribution (Acklam's rational approximation)
+double
+NormalQuantile(double p)
+{
+    static const double a[] = {-3.969683028665376e+01,
+                               2.209460984245205e+02,
+                               -2.759285104469687e+02,
+                               1.383577518672690e+02,
+                               -3.066479806614716e+01,
+                               2.506628277459239e+00};
+    static const double b[] = {-5.447609879822406e+01,
+                               1.615858368580409e+02,
+                               -1.556989798598866e+02,
+                               6.680131188771972e+01,
+                               -1.328068155288572e+01};
+    static const double c[] = {-7.784894002430293e-03,
+                               -3.223964580411365e-01,
+                               -2.400758277161838e+00,
+                               -2.549732539343734e+00,
+                               4.374664141464968e+00,
+                               2.938163982698783e+00};
+    static const double d[] = {7.784695709041462e-03,
+                               3.224671290700398e-01,
+                               2.445134137142996e+00,
+                               3.754408661907416e+00};
+    const double low = 0.02425;
+
+    if (p < low)
+    {
+        double q = std::sqrt(-2 * std::log(p));
+        return (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+               ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1);
+    }
+    if (p > 1 - low)
+    {
+        return -NormalQuantile(1 - p);
+    }
+    double q = p - 0.5;
+    double r = q * q;
+    return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+           (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1);
+}
+
+/// Cumulative distribution of the Student t distribution (Abramowitz and Stegun 26.7.3, 26.7.4)
+double
+StudentTCdf(double t, uint32_t degreesOfFreedom)
+{
+    double theta = std::atan(std::fabs(t) / std::sqrt(degreesOfFreedom));
+    double s = std::sin(theta);
+    double c2 = std::cos(theta) * std::cos(theta);
+    double a;
+    if (degreesOfFreedom % 2 == 1)
+    {
+        double term = s * std::cos(theta);
+        double sum = degreesOfFreedom > 1 ? term : 0;
+        for (uint32_t k = 3; k + 1 < degreesOfFreedom; k += 2)
+        {
+            term *= c2 * (k - 1) / k;
+            sum += term;
+        }
+        a = 2 / M_PI * (theta + sum);
+    }
+    else
+    {
+        double term = 1;
+        double sum = 1;
+        for (uint32_t k = 2; k + 1 < degreesOfFreedom; k += 2)
+        {
+            term *= c2 * (k - 1) / k;
+            sum += term;
+        }
+        a = s * sum;
+    }
+    return t < 0 ? (1 - a) / 2 : (1 + a) / 2;
+}
+
+/// Density of the Student t distribution
+double
+StudentTDensity(double t, uint32_t degreesOfFreedom)
+{
+    double n = degreesOfFreedom;
+    return std::exp(std::lgamma((n + 1) / 2) - std::lgamma(n / 2) -
+                    (n + 1) / 2 * std::log1p(t * t / n)) /
+           std::sqrt(n * M_PI);
+}
+
+} // namespace
+
+double
+LraStudentTQuantile(double p, uint32_t degreesOfFreedom)
+{
+    if (degreesOfFreedom == 1)
+    {
+        return std::tan(M_PI * (p - 0.5));
+    }
+    if (degreesOfFreedom == 2)
+    {
+        return (2 * p - 1) / std::sqrt(2 * p * (1 - p));
+    }
+
+    // Abramowitz and Stegun 26.7.5
+    double z = NormalQuantile(p);
+    double z2 = z * z;
+    double n = degreesOfFreedom;
+    double g1 = (z2 + 1) * z / 4;
+    double g2 = ((5 * z2 + 16) * z2 + 3) * z / 96;
+    double g3 = (((3 * z2 + 19) * z2 + 17) * z2 - 15) * z / 384;
+    double g4 = ((((79 * z2 + 776) * z2 + 1482) * z2 - 1920) * z2 - 945) * z / 92160;
+    double t = z + g1 / n + g2 / (n * n) + g3 / (n * n * n) + g4 / (n * n * n * n);
+
+    // The expansion is off by up to 1% at 3 degrees of freedom in the tails:
+    // polish it with Newton steps on the exact distribution function
+    for (int i = 0; i < 4; i++)
+    {
+        t -= (StudentTCdf(t, degreesOfFreedom) - p) / StudentTDensity(t, degreesOfFreedom);
+    }
+    return t;
+}
+
+LraReplicationStatistic::LraReplicationStatistic(const std::string& name)
+    : m_name(name),
+      m_count(0),
+      m_mean(0),
+      m_m2(0)
+{
+}
+
+void
+LraReplicationStatistic::Add(double value)
+{
+    m_count++;
+    double delta = value - m_mean;
+    m_mean += delta / m_count;
+    m_m2 += delta * (value - m_mean);
+}
+
+const std::string&
+LraReplicationStatistic::GetName() const
+{
+    return m_name;
+}
+
+uint32_t
+LraReplicationStatistic::GetCount() const
+{
+    return m_count;
+}
+
+double
+LraReplicationStatistic::GetMean() const
+{
+    return m_mean;
+}
+
+double
+LraReplicationStatistic::GetVariance() const
+{
+    return m_count > 1 ? m_m2 / (m_count - 1) : 0;
+}
+
+double
+LraReplicationStatistic::GetHalfWidth(double confidence) const
+{
+    if (m_count < 2)
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+    double t = LraStudentTQuantile(1 - (1 - confidence) / 2, m_count - 1);
+    return t * std::sqrt(GetVariance() / m_count);
+}
+
+bool
+LraReplicationStatistic::IsConverged(double confidence, double relativeTarget) const
+{
+    double halfWidth = GetHalfWidth(confidence);
+    if (std::isinf(halfWidth))
+    {
+        return false;
+    }
+    if (m_mean == 0)
+    {
+        return halfWidth == 0;
+    }
+    return halfWidth <= relativeTarget * std::fabs(m_mean);
+}
+
+} // namespace ns3
@@ -0,0 +1,73 @@
+#ifndef LRA_REPLICATION_H
+#define LRA_REPLICATION_H
+
+#include <cstdint>
+#include <string>
+
+/*
+ * Statistics of independent replications of the same configuration, used by
+ * the benchmark to stop replicating once the confidence intervals are narrow
+ * enough. Kept free of ns-3 includes like the other benchmark utilities.
+ */
+
+namespace ns3 {
+
+/**
+ * Quantile of the Student t distribution.
+ * Exact for 1 and 2 degrees of freedom. Otherwise a Cornish-Fisher expansion of
+ * the normal quantile refined by Newton steps on the exact distribution function,
+ * accurate to about 1e-9 relative for p in [0.0005, 0.9995].
+ * \param p probability, in (0, 1)
+ * \param degreesOfFreedom degrees of freedom, at least 1
+ * \return t such that P(T <= t) = p
+ */
+double LraStudentTQuantile (double p, uint32_t degreesOfFreedom);
+
+/**
+ * \brief Running mean and variance of one metric across replications.
+ *
+ * Uses Welford's update, so values can be added one replication at a time.
+ */
+class LraReplicationStatistic
+{
+public:
+  /**
+   * Constructor
+   * \param name metric name, used in reports
+   */
+  explicit LraReplicationStatistic (const std::string &name = "");
+
+  /// Add the value measured by one replication
+  void Add (double value);
+  /// \return the metric name
+  const std::string &GetName () const;
+  /// \return the number of values added
+  uint32_t GetCount () const;
+  /// \return the sample mean
+  double GetMean () const;
+  /// \return the sample variance, 0 with less than two values
+  double GetVariance () const;
+  /**
+   * Half width of the two-sided confidence interval of the mean.
+   * \param confidence confidence level, e.g. 0.95
+   * \return the half width, infinite with less than two values
+   */
+  double GetHalfWidth (double confidence) const;
+  /**
+   * \param confidence confidence level, e.g. 0.95
+   * \param relativeTarget largest accepted ratio between half width and |mean|
+   * \return true if the interval is narrow enough; a metric that was 0 in
+   *         every replication counts as converged
+   */
+  bool IsConverged (double confidence, double relativeTarget) const;
+
+private:
+  std::string m_name; // Metric name
+  uint32_t m_count; // Values added
+  double m_mean; // Running mean
+  double m_m2; // Running sum of squared differences from the mean
+};
+
+} // namespace ns3
+
+#endif /* LRA_REPLICATION_H */
@@ -1,15 +1,26 @@
 #include "lra-routing-protocol.h"
 
+#include "ns3/boolean.h"
+#include "ns3/double.h"
 #include "ns3/ipv4-l3-protocol.h"
 #include "ns3/ipv4-list-routing-helper.h"
 #include "ns3/ipv4-static-routing-helper.h"
 #include "ns3/log.h"
+#include "ns3/queue.h"
+#include "ns3/simple-net-device.h"
 #include "ns3/simulator.h"
 #include "ns3/udp-header.h"
 #include "ns3/udp-l4-protocol.h"
 #include "ns3/udp-socket-factory.h"
+#include "ns3/uinteger.h"
+#include "ns3/wifi-mac-queue.h"
+#include "ns3/wifi-mac.h"
+#include "ns3/wifi-net-device.h"
 
+#include <algorithm>
+#include <cmath>
 #include <ranges>
+#include <tuple>
 
 using namespace std;
 
@@ -19,18 +30,155 @@ namespace ns3
 NS_LOG_COMPONENT_DEFINE("LraRoutingProtocol");
 NS_OBJECT_ENSURE_REGISTERED(LraRoutingProtocol);
 const uint32_t LraRoutingProtocol::LRA_PORT = 654;
-const char* LraRoutingProtocol::LRA_ACK_SEND_MESSAGE = "LRA_ACK_SEND_MESSAGE";
-const char* LraRoutingProtocol::LRA_ACK_RECV_MESSAGE = "LRA_ACK_RECV_MESSAGE";
-const char* LraRoutingProtocol::LRA_HELLO_RECV_MESSAGE = "LRA_HELLO_RECV_MESSAGE";
-const char* LraRoutingProtocol::LRA_HELLO_SEND_MESSAGE = "LRA_HELLO_SEND_MESSAGE";
-const char* LraRoutingProtocol::LRA_REVERSAL_SEND_MESSAGE = "LRA_REVERSAL_SEND_MESSAGE";
+const uint8_t LraRoutingProtocol::LRA_PROTOCOL = 253;
 
 TypeId
 LraRoutingProtocol::GetTypeId(void)
 {
     static TypeId tid = TypeId("ns3::LraRoutingProtocol")
                             .SetParent<Ipv4RoutingProtocol>()
-                            .AddConstructor<LraRoutingProtocol>();
+                            .AddConstructor<LraRoutingProtocol>()
+                            .AddAttribute("LoopSuspicionTimeout",
+                                          "How long a neighbor that closed a forwarding loop is avoided.",
+                                          TimeValue(Seconds(2)),
+                                          MakeTimeAccessor(&LraRoutingProtocol::m_loopSuspicionTimeout),
+                                          MakeTimeChecker())
+                            .AddAttribute("LoopDetectionWindow",
+                                          "How long a forwarded packet is remembered to detect loops.",
+                                          TimeValue(Seconds(1)),
+                                          MakeTimeAccessor(&LraRoutingProtocol::m_loopDetectionWindow),
+                                          MakeTimeChecker())
+                            .AddAttribute("DuplicateCacheLifetime",
+                                          "How long a processed control message is remembered to drop duplicates.",
+                                          TimeValue(Seconds(5)),
+                                          MakeTimeAccessor(&LraRoutingProtocol::m_duplicateCacheLifetime),
+                                          MakeTimeChecker())
+                            .AddAttribute("ReverseRouteLifetime",
+                                          "How long a route toward a data source lives without "
+                                          "packets from or to that source.",
+                                          TimeValue(Seconds(10)),
+                                          MakeTimeAccessor(&LraRoutingProtocol::m_reverseRouteLifetime),
+                                          MakeTimeChecker())
+                            .AddAttribute("AckTimeout",
+                                          "How long an ACK response to a forwarded packet may take "
+                                          "before the link is disabled.",
+                                          TimeValue(MilliSeconds(100)),
+                                          MakeTimeAccessor(&LraRoutingProtocol::m_ackTimeout),
+                                          MakeTimeChecker())
+                            .AddAttribute("FreshnessWindow",
+                                          "Forwarding to a neighbor that answered an ACK probe within "
+                                          "this time sends no new probe; the window is halved on every "
+                                          "ACK timeout and regrows on responses. Zero disables.",
+                                          TimeValue(Seconds(0)),
+                                          MakeTimeAccessor(&LraRoutingProtocol::m_freshnessWindow),
+                                          MakeTimeChecker())
+                            .AddAttribute("TimerResolution",
+                                          "Granularity of the link and loop suspicion timeouts, which "
+                                          "expire on the first tick after their deadline.",
+                                          TimeValue(MilliSeconds(10)),
+                                          MakeTimeAccessor(&LraRoutingProtocol::m_timerResolution),
+                                          MakeTimeChecker(MicroSeconds(1)))
+                            .AddAttribute("AggregationWindow",
+                                          "How long a forwarder holds packets bound for the sink to "
+                                          "merge them into one frame, zero disables aggregation.",
+                                          TimeValue(Seconds(0)),
+                                          MakeTimeAccessor(&LraRoutingProtocol::m_aggregationWindow),
+                                          MakeTimeChecker())
+                            .AddAttribute("AggregationMaxSize",
+                                          "Maximum size of the datagrams merged in one frame (bytes).",
+                                          UintegerValue(1400),
+                                          MakeUintegerAccessor(&LraRoutingProtocol::m_aggregationMaxSize),
+                                          MakeUintegerChecker<uint32_t>(100, 65000))
+                            .AddAttribute("CongestionAware",
+                                          "Choose the outgoing link whose neighbor advertised the "
+                                          "emptiest transmission queue, instead of the highest address.",
+                                          BooleanValue(false),
+                                          MakeBooleanAccessor(&LraRoutingProtocol::m_congestionAware),
+                                          MakeBooleanChecker())
+                            .AddAttribute("LowEnergyThreshold",
+                                          "Remaining energy fraction below which a neighbor is used "
+                                          "only if no other outgoing link is left, zero disables.",
+                                          DoubleValue(0.0),
+                                          MakeDoubleAccessor(&LraRoutingProtocol::m_lowEnergyThreshold),
+                                          MakeDoubleChecker<double>(0.0, 1.0))
+                            .AddAttribute("MobilityAware",
+                                          "Advertise position and velocity in control messages and "
+                                          "avoid next hops whose link is predicted to break soon.",
+                                          BooleanValue(false),
+                                          MakeBooleanAccessor(&LraRoutingProtocol::m_mobilityAware),
+                                          MakeBooleanChecker())
+                            .AddAttribute("LinkRange",
+                                          "Distance beyond which a link is predicted to be broken (m).",
+                                          DoubleValue(100.0),
+                                          MakeDoubleAccessor(&LraRoutingProtocol::m_linkRange),
+                                          MakeDoubleChecker<double>(0.0))
+                            .AddAttribute("LinkLifetimeThreshold",
+                                          "Links predicted to break within this time are used only "
+                                          "if no other outgoing link is left.",
+                                          TimeValue(Seconds(1)),
+                                          MakeTimeAccessor(&LraRoutingProtocol::m_linkLifetimeThreshold),
+                                          MakeTimeChecker())
+                            .AddAttribute("PartitionDetection",
+                                          "Detect components cut off from the sink with TORA reference "
+                                          "levels and stop reversing there, instead of reversing forever.",
+                                          BooleanValue(false),
+                                          MakeBooleanAccessor(&LraRoutingProtocol::m_partitionDetection),
+                                          MakeBooleanChecker())
+                            .AddAttribute("RejoinInterval",
+                                          "Time before the first probe of a partitioned node for a "
+                                          "neighbor connected to the sink, doubled after every probe.",
+                                          TimeValue(Seconds(2)),
+                                          MakeTimeAccessor(&LraRoutingProtocol::m_rejoinInterval),
+                                          MakeTimeChecker())
+                            .AddAttribute("RejoinAttempts",
+                                          "Unanswered rejoin probes after which a partitioned node stops probing.",
+                                          UintegerValue(6),
+                                          MakeUintegerAccessor(&LraRoutingProtocol::m_rejoinAttempts),
+                                          MakeUintegerChecker<uint32_t>(1))
+                            .AddAttribute("AggregatedDiscovery",
+                                          "Bootstrap with periodic broadcasts listing known neighbors and "
+                                          "link orientations instead of one hello response per neighbor.",
+                                          BooleanValue(false),
+                                          MakeBooleanAccessor(&LraRoutingProtocol::m_aggregatedDiscovery),
+                                          MakeBooleanChecker())
+                            .AddAttribute("DiscoveryInterval",
+                                          "Time between two aggregated discovery broadcasts.",
+                                          TimeValue(Seconds(1)),
+                                          MakeTimeAccessor(&LraRoutingProtocol::m_discoveryInterval),
+                                          MakeTimeChecker())
+                            .AddAttribute("DiscoveryRounds",
+                                          "Number of aggregated discovery broadcasts sent by each node.",
+                                          UintegerValue(2),
+                                          MakeUintegerAccessor(&LraRoutingProtocol::m_discoveryRounds),
+                                          MakeUintegerChecker<uint32_t>(1))
+                            .AddTraceSource("LinkStateChange",
+                                            "The orientation of a link changed.",
+                                            MakeTraceSourceAccessor(&LraRoutingProtocol::m_linkStateTrace),
+                                            "ns3::LraRoutingProtocol::LinkStateTracedCallback")
+                            .AddTraceSource("Reversal",
+                                            "The node reversed all its links.",
+                                            MakeTraceSourceAccessor(&LraRoutingProtocol::m_reversalTrace),
+                                            "ns3::LraRoutingProtocol::ReversalTracedCallback")
+                            .AddTraceSource("Forward",
+                                            "A data packet was forwarded.",
+                                            MakeTraceSourceAccessor(&LraRoutingProtocol::m_forwardTrace),
+                                            "ns3::LraRoutingProtocol::ForwardTracedCallback")
+                            .AddTraceSource("LoopDetected",
+                                            "A forwarding loop was detected, the neighbor is suspected.",
+                                            MakeTraceSourceAccessor(&LraRoutingProtocol::m_loopTrace),
+                                            "ns3::LraRoutingProtocol::LoopTracedCallback")
+                            .AddTraceSource("Partition",
+                                            "The node found itself cut off from the sink.",
+                                            MakeTraceSourceAccessor(&LraRoutingProtocol::m_partitionTrace),
+                                            "ns3::LraRoutingProtocol::PartitionTracedCallback")
+                            .AddTraceSource("Rejoin",
+                                            "A partitioned node reached the sink again.",
+                                            MakeTraceSourceAccessor(&LraRoutingProtocol::m_rejoinTrace),
+                                            "ns3::LraRoutingProtocol::RejoinTracedCallback")
+                            .AddTraceSource("Drop",
+                                            "A packet could not be routed.",
+                                            MakeTraceSourceAccessor(&LraRoutingProtocol::m_dropTrace),
+                                            "ns3::LraRoutingProtocol::DropTracedCallback");
     return tid;
 }
 
@@ -39,6 +187,29 @@ LraRoutingProtocol::LraRoutingProtocol()
     NS_LOG_FUNCTION(this);
     hopSum = 0;
     nPacketReceived = 0;
+    m_sequence = 0;
+    m_controlReceived = 0;
+    m_duplicatesSuppressed = 0;
+    m_uniformRandomVariable = CreateObject<UniformRandomVariable>();
+    m_aggregateBytes = 0;
+    m_aggregateFrames = 0;
+    m_aggregatedPackets = 0;
+    m_timerTick = 0;
+    m_pendingTimeouts = 0;
+    m_reversals = 0;
+    m_ackProbesSuppressed = 0;
+    m_partitioned = false;
+    m_rejoinProbes = 0;
+    m_partitions = 0;
+    m_rejoins = 0;
+    m_detached = false;
+    // Control messages never go past the neighbors. The tag is shared by every copy.
+    m_controlTemplate = Create<Packet>();
+    SocketIpTtlTag tag;
+    tag.SetTtl(1);
+    m_controlTemplate->AddPacketTag(tag);
+    m_forwardedFilter.fill(ForwardedEntry{0, 0, Ipv4Address(), Time(0)});
+    m_duplicateCache.fill(DuplicateEntry{0, 0, Time(0)});
 }
 
 LraRoutingProtocol::~LraRoutingProtocol()
@@ -50,6 +221,12 @@ void
 LraRoutingProtocol::DoDispose()
 {
     NS_LOG_FUNCTION(this);
+    m_aggregateEvent.Cancel();
+    m_aggregateQueue.clear();
+    m_timerEvent.Cancel();
+    m_timerWheel.clear();
+    m_rejoinEvent.Cancel();
+    m_routeCache.clear();
     Ipv4RoutingProtocol::DoDispose();
 }
 
@@ -66,34 +243,39 @@ LraRoutingProtocol::RouteOutput(Ptr<Packet> packet,
     // Packet arrived to destination
     if (dest == m_nodeAddress)
     {
-        Ptr<Ipv4Route> route = Create<Ipv4Route>();
-        route->SetSource(m_nodeAddress);
-        route->SetDestination(dest);
-        route->SetGateway(dest);
-        route->SetOutputDevice(m_ipv4->GetNetDevice(1)); // Assume interface 1
         NS_LOG_INFO("Packet local delivery " << m_nodeAddress << " to " << dest);
-        return route;
+        return GetRoute(dest);
     }
 
-    auto neighbor = (dest == m_sink)
-                        ? GetNextHop()
-                        : dest; // if dest is not sink then this is a service packet, all service
-                                // packet have ttl=1 and must be forwarded directly to destination.
+    Ipv4Address neighbor;
+    if (dest == m_sink)
+    {
+        neighbor = GetNextHop();
+    }
+    else if (!LookupReverseRoute(dest, neighbor))
+    {
+        // No traffic from dest went through this node: assume it is a direct neighbor, as
+        // for service packets
+        neighbor = dest;
+    }
     if (neighbor != m_broadcastAddress)
     {
-        // Create route forwarding packet to next hop
-        Ptr<Ipv4Route> route = Create<Ipv4Route>();
-        route->SetSource(m_nodeAddress);
-        route->SetDestination(dest);
-        route->SetGateway(neighbor);                     // Next hop
-        route->SetOutputDevice(m_ipv4->GetNetDevice(1)); // Assume interface 1
-
         NS_LOG_INFO("Packet send from " << m_nodeAddress << " to " << dest << " through "
                                         << neighbor);
+        Ptr<Ipv4Route> route = GetRoute(neighbor);
+        if (IsSink(m_nodeAddress) && m_nodeAddress != m_sink)
+        {
+            // Sources are connected to the anycast address: every sink answers from it, or
+            // the replies of the other sinks would be dropped by the sources' sockets
+            Ptr<Ipv4Route> anycast = Create<Ipv4Route>(*route);
+            anycast->SetSource(m_sink);
+            return anycast;
+        }
         return route;
     }
 
     // No route found
+    m_dropTrace(packet, header, LraDropReason::NoRoute);
     sockerr = Socket::ERROR_NOROUTETOHOST;
     return nullptr;
 }
@@ -112,8 +294,7 @@ LraRoutingProtocol::RouteInput(Ptr<const Packet> p,
         return false;
     }
 
-    std::string payload = GetPacketPayload(p);
-    NS_LOG_FUNCTION(this << header << p->GetUid() << payload);
+    NS_LOG_FUNCTION(this << header << p->GetUid());
     int32_t iif = 1;
     Ipv4Address dest = header.GetDestination();
     Ipv4Address origin = header.GetSource();
@@ -122,389 +303,1699 @@ LraRoutingProtocol::RouteInput(Ptr<const Packet> p,
 
     if(ttl <= 0) return false;
 
-    // Packet arrived to destination
-    if (dest == m_nodeAddress || dest == m_broadcastAddress)
+    // Packet arrived to destination, every sink answers to the anycast address
+    if (dest == m_nodeAddress || dest == m_broadcastAddress ||
+        (dest == m_sink && IsSink(m_nodeAddress)))
     {
         // Check if service message
-        auto status = RecvLraServiceMessage(payload, origin);
-        if(status == RecvLraStatus::Error) return false;
-        else if(status == RecvLraStatus::NotService)
+        if (header.GetProtocol() == LRA_PROTOCOL)
         {
-            NS_LOG_INFO("Packet delivered to " << m_nodeAddress << " from " << origin);
-            hopSum += float(static_cast<int>(ttlMax) - static_cast<int>(ttl));
-            nPacketReceived++;
+            LraHeader lraHeader;
+            p->PeekHeader(lraHeader);
+            if (!lraHeader.IsValid()) return false;
+            if (IsDuplicate(origin, lraHeader.GetSequence()))
+            {
+                NS_LOG_INFO("Duplicate " << lraHeader << " from " << origin << " ignored");
+                m_duplicatesSuppressed++;
+                return true;
+            }
+            m_controlReceived++;
+            NeighborEntry& sender = GetNeighbor(origin);
+            sender.congestion = lraHeader.GetCongestion();
+            sender.energy = lraHeader.GetEnergy();
+            if (m_mobilityAware && lraHeader.HasMobility())
+            {
+                UpdateNeighborMotion(origin, lraHeader);
+            }
+            if (lraHeader.GetType() == LRA_AGGREGATE)
+            {
+                // Inner packets go through the usual delivery and forwarding paths
+                RecvAggregate(p, origin, idev, ucb, mcb, lcb, ecb);
+                return true;
+            }
+            auto status = RecvLraServiceMessage(lraHeader, p, origin);
+            return status == RecvLraStatus::Service;
         }
+
+        NS_LOG_INFO("Packet delivered to " << m_nodeAddress << " from " << origin);
+        LearnReverseRoute(p, header);
+        hopSum += float(static_cast<int>(ttlMax) - static_cast<int>(ttl));
+        nPacketReceived++;
         lcb(p, header, iif);
         return true;
     }
 
     if (dest == m_sink)
     {
+        // The packet already went through this node: the neighbor chosen last time closed a
+        // loop. Avoid it for a while and repair locally with the next best choice.
+        Ipv4Address previousHop;
+        if (LookupForwarded(header, previousHop))
+        {
+            NS_LOG_INFO("Loop detected at " << m_nodeAddress << " through " << previousHop);
+            SuspectLoop(previousHop);
+        }
+
+        LearnReverseRoute(p, header);
+        if (!m_aggregationWindow.IsZero() && ttl > 1 &&
+            p->GetSize() + header.GetSerializedSize() <= m_aggregationMaxSize)
+        {
+            EnqueueForAggregation(p, header);
+            return true;
+        }
+
         auto neighbor = GetNextHop();
         if (neighbor != m_broadcastAddress)
         {
-            // Create route forwarding packet to next hop
-            Ptr<Ipv4Route> route = Create<Ipv4Route>();
-            route->SetSource(origin);
-            route->SetDestination(dest);
-            route->SetGateway(neighbor);
-            route->SetOutputDevice(m_ipv4->GetNetDevice(1));
+            Ptr<Ipv4Route> route = GetRoute(neighbor);
             NS_LOG_INFO("Packet forwarded from " << m_nodeAddress << " to " << neighbor << " for "
                                                  << dest << " and source " << origin);
 
-            ucb(route, p, header);
+            RememberForwarded(header, neighbor);
+            ucb(route, TagForwarded(p), header);
+            m_forwardTrace(p, header, neighbor);
 
             SendAckRequestMessage(neighbor);
             return true;
         }
     }
+    else
+    {
+        // Downstream traffic, e.g. replies of the sink, follows the path its source used
+        Ipv4Address neighbor;
+        if (LookupReverseRoute(dest, neighbor))
+        {
+            Ptr<Ipv4Route> route = GetRoute(neighbor);
+            NS_LOG_INFO("Packet forwarded back from " << m_nodeAddress << " to " << neighbor
+                                                      << " for " << dest);
+
+            ucb(route, TagForwarded(p), header);
+            m_forwardTrace(p, header, neighbor);
+            return true;
+        }
+    }
 
     // No route found
     NS_LOG_INFO("No route found for packet.");
+    m_dropTrace(p, header, LraDropReason::NoRoute);
     ecb(p, header, Socket::ERROR_NOROUTETOHOST);
     return false;
 }
 
 void
-LraRoutingProtocol::InitializeNode(Ipv4Address sinkAddress, int index)
+LraRoutingProtocol::SetSinks(const std::vector<Ipv4Address>& sinks)
+{
+    NS_ASSERT_MSG(!sinks.empty(), "At least one sink is needed");
+    m_sinks = sinks;
+    m_sink = sinks.front();
+}
+
+bool
+LraRoutingProtocol::IsSink(Ipv4Address address) const
+{
+    // A handful of gateways at most, a linear scan is enough
+    return std::find(m_sinks.begin(), m_sinks.end(), address) != m_sinks.end();
+}
+
+bool
+LraRoutingProtocol::PointsToward(Ipv4Address neighbor) const
+{
+    // Seeding every sink as a root: links between a sink and another node always point to
+    // the sink, the address order breaks the remaining ties so both ends agree
+    bool neighborIsSink = IsSink(neighbor);
+    if (neighborIsSink != IsSink(m_nodeAddress))
+    {
+        return neighborIsSink;
+    }
+    return m_nodeAddress < neighbor;
+}
+
+void
+LraRoutingProtocol::InitializeNode(const std::vector<Ipv4Address>& sinks, int index)
 {
-    NS_LOG_FUNCTION(this << sinkAddress << index);
+    NS_LOG_FUNCTION(this << sinks.size() << index);
 
-    m_sink = sinkAddress;
+    SetSinks(sinks);
     m_index = index;
+    m_mobility = m_ipv4->GetObject<MobilityModel>();
 
-    int randDelay = rand() % 1000;
+    int randDelay = m_uniformRandomVariable->GetInteger(0, 999);
     Time jitter = Time(MilliSeconds((double)index * 1000.0L + randDelay));
-    if (m_nodeAddress == m_sink)
+    if (IsSink(m_nodeAddress))
         jitter = Time(MilliSeconds(1));
-    Simulator::Schedule(jitter, &LraRoutingProtocol::SendHelloMessage, this, m_broadcastAddress);
+    StartDiscovery(jitter);
 
-    NS_LOG_INFO("Node " << m_nodeAddress << " initialized with sink address " << m_sink << " and "
-                        << m_neighbors.size() << " neighbors.");
+    NS_LOG_INFO("Node " << m_nodeAddress << " initialized with sink address " << m_sink << " ("
+                        << m_sinks.size() << " sinks) and " << m_neighbors.size()
+                        << " neighbors.");
 }
 
 void
-LraRoutingProtocol::DisableLinkTo(Ipv4Address destination, bool avoidReverse)
+LraRoutingProtocol::StartDiscovery(Time jitter)
 {
-    NS_LOG_FUNCTION(this << destination);
-    NS_LOG_INFO("Node " << m_nodeAddress << " disables link to " << destination);
+    NS_LOG_FUNCTION(this << jitter);
 
-    m_neighbors.insert(destination);
-
-    if (m_linkStatus[destination] != 0)
+    // Kept in m_discoveryEvent in both modes, so that an interface going down cancels it
+    m_discoveryEvent.Cancel();
+    if (m_aggregatedDiscovery)
+    {
+        m_discoveryEvent =
+            Simulator::Schedule(jitter, &LraRoutingProtocol::SendDiscoveryMessage, this, 0);
+    }
+    else
     {
-        m_linkStatus[destination] = 0;
+        m_discoveryEvent = Simulator::Schedule(jitter,
+                                               &LraRoutingProtocol::SendHelloMessage,
+                                               this,
+                                               m_broadcastAddress);
     }
+}
 
-    m_disableLinkToEvent.erase(destination); // erase events linked to this ip address
+void
+LraRoutingProtocol::ClearRoutingState()
+{
+    NS_LOG_FUNCTION(this);
+    NS_LOG_INFO("Node " << m_nodeAddress << " drops " << m_neighbors.size() << " neighbors");
 
-    if (m_nodeAddress != m_sink)
+    for (const auto& entry : m_neighbors)
     {
-        if (!HasNextHop() && !avoidReverse)
+        if (entry.linked)
         {
-            LinkReversal();
-            // Notify all nodes that you are now in active state.
-            SendReversalMessage(m_broadcastAddress);
+            m_linkStateTrace(Ipv4Address(entry.address), entry.state, -1);
         }
+    }
+    m_neighbors.clear();
+    m_neighborMotion.clear();
+    m_neighborLevels.clear();
+    m_reverseRoutes.clear();
+    m_forwardedFilter.fill(ForwardedEntry{0, 0, Ipv4Address(), Time(0)});
+
+    m_timerEvent.Cancel();
+    for (auto& slot : m_timerWheel)
+    {
+        slot.clear();
+    }
+    m_pendingTimeouts = 0;
 
-        if (!HasNextHop())
-        { // link reversal caused cascading reversals in other nodes that bringed this node to have
-          // no outgoing route again. So this is an unconnected component to the sink.
-            initialized = false;
-        }
+    m_aggregateEvent.Cancel();
+    for (const auto& entry : m_aggregateQueue)
+    {
+        m_dropTrace(entry.payload, entry.header, LraDropReason::InterfaceDown);
     }
+    m_aggregateQueue.clear();
+    m_aggregateBytes = 0;
+
+    m_discoveryEvent.Cancel();
+    m_rejoinEvent.Cancel();
+    m_partitioned = false;
+    m_level = ReferenceLevel();
+    InvalidateRoutes();
+    initialized = false;
 }
 
 void
-LraRoutingProtocol::EnableLinkTo(Ipv4Address destination)
+LraRoutingProtocol::Reattach()
 {
-    NS_LOG_FUNCTION(this << destination);
-    NS_LOG_INFO("Node " << m_nodeAddress << " enables link to " << destination);
-
-    m_neighbors.insert(destination);
-
-    if (m_linkStatus[destination] != 1)
-    {
-        m_linkStatus[destination] = 1;
-    }
+    NS_LOG_FUNCTION(this);
+    NS_LOG_INFO("Node " << m_nodeAddress << " rediscovers its neighbors");
 
-    m_disableLinkToEvent.erase(destination); // erase events linked to this ip address
+    m_detached = false;
+    // The neighbors answer the hellos with the same rule as at startup, the links that lead
+    // nowhere are reversed by the first packet that needs them
+    StartDiscovery(Time(MilliSeconds(m_uniformRandomVariable->GetInteger(0, 999))));
 }
 
 void
-LraRoutingProtocol::InitLinkTo(Ipv4Address destination)
+LraRoutingProtocol::WarmStart(const std::vector<Ipv4Address>& sinks,
+                              int index,
+                              const std::vector<std::pair<Ipv4Address, int>>& links)
 {
-    NS_LOG_FUNCTION(this << destination);
-    NS_LOG_INFO("Node " << m_nodeAddress << " init link to " << destination);
+    NS_LOG_FUNCTION(this << sinks.size() << index << links.size());
+
+    SetSinks(sinks);
+    m_index = index;
+    m_mobility = m_ipv4->GetObject<MobilityModel>();
+    m_neighbors.reserve(links.size());
+    for (const auto& link : links)
+    {
+        SetLinkStatus(link.first, link.second);
+    }
+    initialized = true;
 
-    m_neighbors.insert(destination);
-    m_linkStatus[destination] = -1;
-    m_disableLinkToEvent.erase(destination); // erase events linked to this ip address
+    NS_LOG_INFO("Node " << m_nodeAddress << " warm started with sink address " << m_sink
+                        << " and " << m_neighbors.size() << " neighbors.");
 }
 
 void
-LraRoutingProtocol::LinkReversal()
+LraRoutingProtocol::DisableLinkTo(Ipv4Address destination, bool avoidReverse, bool linkFailure)
 {
-    NS_LOG_FUNCTION(this);
+    NS_LOG_FUNCTION(this << destination);
+    NS_LOG_INFO("Node " << m_nodeAddress << " disables link to " << destination);
 
-    // Recursion base case
-    if (m_nodeAddress == m_sink)
+    SetLinkStatus(destination, 0);
+    CancelLinkTimeout(destination);
+    if (linkFailure)
     {
-        return;
+        PurgeReverseRoutes(destination);
+    }
+    if (linkFailure && m_partitionDetection)
+    {
+        // The failed link is removed, the next message heard from the neighbor restores it
+        GetNeighbor(destination).linked = false;
+        InvalidateRoutes(destination);
+        m_linkStateTrace(destination, 0, -1);
     }
 
-    // Actual inversion
-    for (auto neighbor : m_neighbors)
+    if (!IsSink(m_nodeAddress) && !HasNextHop() && !avoidReverse)
     {
-        if (neighbor != m_broadcastAddress)
-        {
-            m_linkStatus[neighbor] = 1;
-        }
+        ReverseLinks(linkFailure);
     }
 }
 
 void
-LraRoutingProtocol::SendAckRequestMessage(Ipv4Address destination)
+LraRoutingProtocol::EnableLinkTo(Ipv4Address destination)
 {
-    NS_LOG_FUNCTION(this << destination << m_nodeAddress);
+    NS_LOG_FUNCTION(this << destination);
+    NS_LOG_INFO("Node " << m_nodeAddress << " enables link to " << destination);
 
-    // Send ack request if no other ack requst were send to this dest
-    if (m_disableLinkToEvent.find(destination) == m_disableLinkToEvent.end())
-    {
-        SendServiceMessagePacket(destination, LraRoutingProtocol::LRA_ACK_SEND_MESSAGE);
+    SetLinkStatus(destination, 1);
+    CancelLinkTimeout(destination);
+}
 
-        Time jitter = Time(MilliSeconds(100));
-        auto scheduledEventId = Simulator::Schedule(jitter,
-                                                    &LraRoutingProtocol::DisableLinkTo,
-                                                    this,
-                                                    destination,
-                                                    false);
-        m_disableLinkToEvent[destination] = scheduledEventId;
+void
+LraRoutingProtocol::InitLinkTo(Ipv4Address destination)
+{
+    NS_LOG_FUNCTION(this << destination);
+    NS_LOG_INFO("Node " << m_nodeAddress << " init link to " << destination);
 
-        NS_LOG_INFO("Ack Packet request send from " << m_nodeAddress << " to " << destination);
-    }
+    SetLinkStatus(destination, -1);
+    CancelLinkTimeout(destination);
 }
 
 void
-LraRoutingProtocol::SendAckResponseMessage(Ipv4Address origin)
+LraRoutingProtocol::SetLinkStatus(Ipv4Address neighbor, int status)
 {
-    SendServiceMessagePacket(origin, LraRoutingProtocol::LRA_ACK_RECV_MESSAGE);
-    NS_LOG_INFO("ACK Packet response send to " << m_nodeAddress << " from " << origin);
+    NeighborEntry& entry = GetNeighbor(neighbor);
+    if (entry.linked && entry.state == status)
+    {
+        return;
+    }
+    int oldStatus = entry.linked ? entry.state : -1;
+    entry.linked = true;
+    entry.state = status;
+    m_linkStateTrace(neighbor, oldStatus, status);
 }
 
-void
-LraRoutingProtocol::SendHelloMessage(Ipv4Address destination)
+bool
+LraRoutingProtocol::HasLinks() const
 {
-    NS_LOG_FUNCTION(this << destination << m_nodeAddress);
-    NS_LOG_INFO("SendHelloMessage " << m_nodeAddress << " " << destination);
+    return std::any_of(m_neighbors.begin(), m_neighbors.end(), [](const NeighborEntry& entry) {
+        return entry.linked;
+    });
+}
 
-    SendServiceMessagePacket(destination, LraRoutingProtocol::LRA_HELLO_SEND_MESSAGE);
+LraRoutingProtocol::NeighborEntry*
+LraRoutingProtocol::FindNeighbor(Ipv4Address neighbor)
+{
+    uint32_t address = neighbor.Get();
+    auto it = std::lower_bound(m_neighbors.begin(),
+                               m_neighbors.end(),
+                               address,
+                               [](const NeighborEntry& entry, uint32_t value) {
+                                   return entry.address < value;
+                               });
+    return (it != m_neighbors.end() && it->address == address) ? &*it : nullptr;
+}
 
-    initialized = true;
+const LraRoutingProtocol::NeighborEntry*
+LraRoutingProtocol::FindNeighbor(Ipv4Address neighbor) const
+{
+    return const_cast<LraRoutingProtocol*>(this)->FindNeighbor(neighbor);
 }
 
-void
-LraRoutingProtocol::SendHelloResponseMessage(Ipv4Address origin)
+LraRoutingProtocol::NeighborEntry&
+LraRoutingProtocol::GetNeighbor(Ipv4Address neighbor)
 {
-    NS_LOG_FUNCTION(this << origin);
-    NS_LOG_INFO("SendHelloResponseMessage " << m_nodeAddress << " " << origin);
+    uint32_t address = neighbor.Get();
+    auto it = std::lower_bound(m_neighbors.begin(),
+                               m_neighbors.end(),
+                               address,
+                               [](const NeighborEntry& entry, uint32_t value) {
+                                   return entry.address < value;
+                               });
+    if (it == m_neighbors.end() || it->address != address)
+    {
+        // Until it advertises otherwise, a new neighbor is idle and has a full battery
+        it = m_neighbors.insert(it, NeighborEntry{address, -1, 0, 255, false, 0, 0, 0, 0});
+    }
+    return *it;
+}
 
-    SendServiceMessagePacket(origin, LraRoutingProtocol::LRA_HELLO_RECV_MESSAGE);
+uint32_t
+LraRoutingProtocol::GetTimerTick(Time time) const
+{
+    // First tick at or after the given time
+    int64_t resolution = m_timerResolution.GetTimeStep();
+    return static_cast<uint32_t>((time.GetTimeStep() + resolution - 1) / resolution);
 }
 
 void
-LraRoutingProtocol::SendReversalMessage(Ipv4Address destination)
+LraRoutingProtocol::ArmLinkTimeout(Ipv4Address neighbor)
 {
-    NS_LOG_FUNCTION(this << destination << m_nodeAddress);
-    NS_LOG_INFO("SendReversalMessage " << m_nodeAddress << " " << destination);
+    if (m_timerWheel.empty())
+    {
+        // Every deadline must fall within one turn of the wheel
+        m_timerWheel.resize(GetTimerTick(m_ackTimeout) + 2);
+    }
+    if (!m_timerEvent.IsPending())
+    {
+        m_timerTick = GetTimerTick(Simulator::Now());
+        Time tickTime = TimeStep(m_timerResolution.GetTimeStep() * m_timerTick);
+        m_timerEvent = Simulator::Schedule(tickTime - Simulator::Now(),
+                                           &LraRoutingProtocol::AdvanceTimerWheel,
+                                           this);
+    }
 
-    SendServiceMessagePacket(destination, LraRoutingProtocol::LRA_REVERSAL_SEND_MESSAGE);
+    NeighborEntry& entry = GetNeighbor(neighbor);
+    if (entry.ackDeadline == 0)
+    {
+        m_pendingTimeouts++;
+    }
+    entry.ackDeadline = std::max(GetTimerTick(Simulator::Now() + m_ackTimeout), m_timerTick + 1);
+    m_timerWheel[entry.ackDeadline % m_timerWheel.size()].push_back(entry.address);
 }
 
 void
-LraRoutingProtocol::SendServiceMessagePacket(Ipv4Address destination, const char* type)
+LraRoutingProtocol::CancelLinkTimeout(Ipv4Address neighbor)
 {
-    NS_LOG_FUNCTION(this << destination << type);
-
-    Ptr<Ipv4Route> ackRoute = Create<Ipv4Route>();
-    ackRoute->SetSource(m_nodeAddress);
-    ackRoute->SetDestination(destination);
-    ackRoute->SetGateway(destination);                  // Next hop
-    ackRoute->SetOutputDevice(m_ipv4->GetNetDevice(1)); // Assume interface 1
-
-    std::ostringstream oss;
-    oss << m_nodeAddress;
-    std::string addrStr = oss.str();
+    NeighborEntry* entry = FindNeighbor(neighbor);
+    if (entry && entry->ackDeadline != 0)
+    {
+        entry->ackDeadline = 0; // the slot item is skipped when its tick comes
+        m_pendingTimeouts--;
+    }
+}
 
-    uint32_t textSize = std::strlen(type); // Include null terminator
-    Ptr<Packet> ackPacket = Create<Packet>((uint8_t*)type, textSize);
-    SocketIpTtlTag tag;
-    uint8_t ttl = 1;
-    tag.SetTtl(ttl);
-    ackPacket->AddPacketTag(tag);
-    m_ipv4->Send(ackPacket, m_nodeAddress, destination, Ipv4L3Protocol::PROT_NUMBER, ackRoute);
+bool
+LraRoutingProtocol::HasLinkTimeout(Ipv4Address neighbor) const
+{
+    const NeighborEntry* entry = FindNeighbor(neighbor);
+    return entry && entry->ackDeadline != 0;
 }
 
-Ipv4Address
-LraRoutingProtocol::GetNextHop()
+void
+LraRoutingProtocol::AdvanceTimerWheel()
 {
-    auto nextHop = _GetNextHop();
-    if (nextHop != m_broadcastAddress)
+    NS_LOG_FUNCTION(this << m_timerTick);
+
+    // Deadlines armed while expiring fall at later ticks, hence in other slots
+    std::vector<uint32_t>& slot = m_timerWheel[m_timerTick % m_timerWheel.size()];
+    for (size_t i = 0; i < slot.size(); ++i)
     {
-        return nextHop;
+        NeighborEntry* entry = FindNeighbor(Ipv4Address(slot[i]));
+        if (entry && entry->ackDeadline == m_timerTick)
+        {
+            entry->ackDeadline = 0;
+            m_pendingTimeouts--;
+            // A failing link is probed more often until it answers again
+            entry->confirmedTick = 0;
+            entry->freshnessShift = std::min(entry->freshnessShift + 1, 8);
+            DisableLinkTo(Ipv4Address(slot[i]), false, true);
+        }
+    }
+    slot.clear();
+    m_timerTick++;
+
+    if (m_pendingTimeouts > 0)
+    {
+        m_timerEvent =
+            Simulator::Schedule(m_timerResolution, &LraRoutingProtocol::AdvanceTimerWheel, this);
     }
     else
     {
-        if (nextHop == m_broadcastAddress && m_neighbors.size() > 0)
+        // Idle: drop the cancelled items, the ticks they wait for will not be processed
+        for (auto& other : m_timerWheel)
         {
-            LinkReversal();
-            auto nextHop = _GetNextHop();
-            // Notify all nodes that you are now in active state.
-            SendReversalMessage(m_broadcastAddress);
-            return nextHop;
+            other.clear();
         }
     }
-
-    return m_broadcastAddress;
 }
 
-Ipv4Address
-LraRoutingProtocol::_GetNextHop()
+void
+LraRoutingProtocol::LinkReversal()
 {
-    if (m_nodeAddress == m_sink)
+    NS_LOG_FUNCTION(this);
+
+    // Recursion base case
+    if (IsSink(m_nodeAddress))
     {
-        return m_broadcastAddress;
+        return;
     }
 
-    // To speed up routing is always better to deliver the packet with higher ip address.
-    for (auto iter = m_neighbors.rbegin(); iter != m_neighbors.rend(); ++iter)
+    // Actual inversion
+    uint32_t reversed = 0;
+    for (auto& entry : m_neighbors)
     {
-        auto neighbor = *iter;
-        if (neighbor == m_broadcastAddress)
-            continue;
-        if (m_linkStatus[neighbor] == 1 || m_nodeAddress == m_sink)
+        Ipv4Address neighbor(entry.address);
+        // Neighbors already at the level of this reversal keep their links toward this node
+        if (entry.linked && neighbor != m_broadcastAddress &&
+            (!m_partitionDetection || GetNeighborLevel(neighbor) < m_level))
         {
-            if (m_cycleDetection[neighbor] < 3)
-            { // Check if nodes makes a connected component with no route to the sink
-                NS_LOG_FUNCTION(this << neighbor);
-                return neighbor;
-            }
-            else
-            {
-                continue; // check next neighbor
-            }
-        }
-        if (m_linkStatus[neighbor] == -1)
-        {
-            EnableLinkTo(neighbor);
-            NS_LOG_FUNCTION(this << neighbor);
-            return neighbor;
+            reversed += (entry.state != 1);
+            SetLinkStatus(neighbor, 1);
         }
     }
-    NS_LOG_FUNCTION(this << m_broadcastAddress);
+    m_reversals++;
+    m_reversalTrace(reversed);
+}
 
-    return m_broadcastAddress; // fallback address
+bool
+LraRoutingProtocol::ReferenceLevel::operator<(const ReferenceLevel& other) const
+{
+    return std::tie(tick, origin, reflected) < std::tie(other.tick, other.origin, other.reflected);
 }
 
 bool
-LraRoutingProtocol::HasNextHop()
+LraRoutingProtocol::ReferenceLevel::operator==(const ReferenceLevel& other) const
 {
-    return _GetNextHop() != m_broadcastAddress; // fallback address
+    return tick == other.tick && origin == other.origin && reflected == other.reflected;
 }
 
-RecvLraStatus
-LraRoutingProtocol::RecvLraServiceMessage(std::string payload, Ipv4Address origin)
+void
+LraRoutingProtocol::ReverseLinks(bool linkFailure)
 {
-    // Ack request received
-    if (payload == std::string(LraRoutingProtocol::LRA_ACK_SEND_MESSAGE))
+    NS_LOG_FUNCTION(this << linkFailure);
+
+    if (!m_partitionDetection)
     {
-        NS_LOG_INFO("ACK Packet request delivered to " << m_nodeAddress << " from " << origin);
-        DisableLinkTo(origin);
-        if (m_linkStatus[origin] == 1)
-        {
-            NS_LOG_INFO("Cycle between " << m_nodeAddress << " from " << origin);
-            m_cycleDetection[origin]++;
-            return RecvLraStatus::Error;
-        }
-        SendAckResponseMessage(origin);
+        LinkReversal();
+        // Notify all nodes that you are now in active state.
+        SendReversalMessage(m_broadcastAddress);
+        return;
     }
-    // Ack response received
-    else if (payload == std::string(LraRoutingProtocol::LRA_ACK_RECV_MESSAGE))
+    if (m_partitioned)
     {
-        NS_LOG_INFO("ACK Packet response delivered to " << m_nodeAddress << " from " << origin);
-        if (m_disableLinkToEvent.find(origin) != m_disableLinkToEvent.end())
-        {
-            m_disableLinkToEvent[origin].Cancel(); // link is active, avoid to disable the link.
-            m_disableLinkToEvent.erase(origin);
-        }
-        EnableLinkTo(origin);
+        // Quiescent until a connected neighbor answers a rejoin probe
+        return;
     }
-    // Hello message received
-    else if (payload == std::string(LraRoutingProtocol::LRA_HELLO_SEND_MESSAGE))
-    {
-        NS_LOG_INFO("Hello Packet delivered to " << m_nodeAddress << " from " << origin);
-        if (m_nodeAddress < origin)
-        {
-            EnableLinkTo(origin);
-        }
-        else
-        {
-            DisableLinkTo(origin, true);
-        }
 
-        int randJitter = rand() % 1000;
-        Time jitter = Time(MilliSeconds(randJitter));
-        Simulator::Schedule(jitter,
-                            &LraRoutingProtocol::SendHelloResponseMessage,
-                            this,
-                            origin);
+    ReferenceLevel fresh;
+    fresh.tick = GetTimerTick(Simulator::Now());
+    fresh.origin = m_nodeAddress.Get();
+    if (!HasLinks())
+    {
+        // Every link failed: nobody is left to reverse toward
+        EnterPartition(fresh);
+        return;
     }
-    // Hello message response received
-    else if (payload == std::string(LraRoutingProtocol::LRA_HELLO_RECV_MESSAGE))
+
+    // TORA cases, from the levels of the neighbors
+    bool first = true;
+    bool same = true;
+    ReferenceLevel common;
+    ReferenceLevel highest;
+    for (const auto& entry : m_neighbors)
     {
-        NS_LOG_INFO("Hello Packet response delivered to " << m_nodeAddress << " from "
-                                                            << origin);
-        if (m_nodeAddress < origin)
-        {
-            EnableLinkTo(origin);
-        }
-        else
+        if (!entry.linked)
         {
-            DisableLinkTo(origin, true);
+            continue;
         }
+        ReferenceLevel level = GetNeighborLevel(Ipv4Address(entry.address));
+        same = same && (first || level == common);
+        common = first ? level : common;
+        highest = std::max(highest, level);
+        first = false;
     }
-    // Set passive response received
-    else if (payload == std::string(LraRoutingProtocol::LRA_REVERSAL_SEND_MESSAGE))
+    if (linkFailure || highest.origin == 0)
     {
-        DisableLinkTo(origin);
+        m_level = fresh; // Generate
     }
-    else{
-        return RecvLraStatus::NotService;
+    else if (!same)
+    {
+        m_level = highest; // Propagate
     }
-    return RecvLraStatus::Service;
+    else if (!common.reflected)
+    {
+        // The wave reached a dead end: send it back toward its origin
+        m_level = common;
+        m_level.reflected = true;
+    }
+    else if (common.origin == m_nodeAddress.Get())
+    {
+        // Every neighbor reflected the wave this node started: no path to the sink is left
+        NS_LOG_INFO("Node " << m_nodeAddress << " detected a partition");
+        EnterPartition(common);
+        return;
+    }
+    else
+    {
+        m_level = fresh; // A reflected wave of another node: start over
+    }
+
+    LinkReversal();
+    SendReversalMessage(m_broadcastAddress);
+}
+
+LraRoutingProtocol::ReferenceLevel
+LraRoutingProtocol::GetNeighborLevel(Ipv4Address neighbor) const
+{
+    uint32_t address = neighbor.Get();
+    auto it = std::lower_bound(m_neighborLevels.begin(),
+                               m_neighborLevels.end(),
+                               address,
+                               [](const NeighborLevel& entry, uint32_t value) {
+                                   return entry.address < value;
+                               });
+    return (it != m_neighborLevels.end() && it->address == address) ? it->level
+                                                                    : ReferenceLevel();
 }
 
 void
-LraRoutingProtocol::PrintRoutingTable(Ptr<OutputStreamWrapper> stream, Time::Unit unit) const
+LraRoutingProtocol::SetNeighborLevel(Ipv4Address neighbor, const ReferenceLevel& level)
 {
-    NS_LOG_FUNCTION(this);
-    for (auto neighbor : m_neighbors)
+    uint32_t address = neighbor.Get();
+    auto it = std::lower_bound(m_neighborLevels.begin(),
+                               m_neighborLevels.end(),
+                               address,
+                               [](const NeighborLevel& entry, uint32_t value) {
+                                   return entry.address < value;
+                               });
+    if (it == m_neighborLevels.end() || it->address != address)
     {
-        *stream->GetStream() << m_nodeAddress << "\t" << neighbor << "\t" << m_linkStatus.at(neighbor)
-               << std::endl;
+        it = m_neighborLevels.insert(it, NeighborLevel{address, level});
     }
+    it->level = level;
 }
 
-std::string
-LraRoutingProtocol::GetPacketPayload(Ptr<const Packet> p)
+LraRoutingProtocol::ReferenceLevel
+LraRoutingProtocol::ReadLevel(Ptr<const Packet> packet) const
 {
-    // Read packet data
-    uint32_t packetSize = p->GetSize();
-    uint8_t* buffer = new uint8_t[packetSize];
-    p->CopyData(buffer, packetSize);
-    std::string payload = std::string((char*)buffer, packetSize);
-    delete[] buffer;
-    return payload;
+    Ptr<Packet> copy = packet->Copy();
+    LraHeader header;
+    LraReferenceLevelHeader levelHeader;
+    copy->RemoveHeader(header);
+    copy->RemoveHeader(levelHeader);
+    ReferenceLevel level;
+    level.tick = levelHeader.GetTick();
+    level.origin = levelHeader.GetOrigin().Get();
+    level.reflected = levelHeader.IsReflected();
+    return level;
+}
+
+void
+LraRoutingProtocol::EnterPartition(const ReferenceLevel& level)
+{
+    NS_LOG_FUNCTION(this);
+
+    m_level = level;
+    m_partitioned = true;
+    m_partitions++;
+    m_partitionTrace(Ipv4Address(level.origin));
+
+    // Every member of the component repeats the news once
+    Ptr<Packet> body = NewControlPacket();
+    body->AddHeader(
+        LraReferenceLevelHeader(level.tick, Ipv4Address(level.origin), level.reflected));
+    SendServiceMessagePacket(m_broadcastAddress, LRA_PARTITION, body);
+
+    Time jitter = Time(MilliSeconds(m_uniformRandomVariable->GetInteger(0, 999)));
+    m_rejoinProbes = 0;
+    m_rejoinEvent.Cancel();
+    m_rejoinEvent =
+        Simulator::Schedule(m_rejoinInterval + jitter, &LraRoutingProtocol::SendRejoinMessage, this);
+}
+
+void
+LraRoutingProtocol::SendRejoinMessage()
+{
+    NS_LOG_FUNCTION(this);
+
+    if (!m_partitioned)
+    {
+        return;
+    }
+    SendServiceMessagePacket(m_broadcastAddress, LRA_REJOIN);
+    if (++m_rejoinProbes >= m_rejoinAttempts)
+    {
+        // A component that stays cut off must not keep the simulation alive
+        NS_LOG_INFO("Node " << m_nodeAddress << " stops probing after " << m_rejoinProbes
+                            << " rejoin probes");
+        return;
+    }
+    // Exponential backoff: the gaps double from RejoinInterval
+    Time jitter = Time(MilliSeconds(m_uniformRandomVariable->GetInteger(0, 99)));
+    uint32_t backoff = 1u << std::min<uint32_t>(m_rejoinProbes, 16);
+    m_rejoinEvent = Simulator::Schedule(m_rejoinInterval * backoff + jitter,
+                                        &LraRoutingProtocol::SendRejoinMessage,
+                                        this);
+}
+
+void
+LraRoutingProtocol::Rejoin(Ipv4Address neighbor)
+{
+    NS_LOG_FUNCTION(this << neighbor);
+    NS_LOG_INFO("Node " << m_nodeAddress << " rejoins the sink through " << neighbor);
+
+    m_partitioned = false;
+    m_rejoins++;
+    m_rejoinEvent.Cancel();
+    m_level = ReferenceLevel();
+
+    // The links inside the component lead nowhere: forward only through the neighbor that
+    // answered, the others get linked again by their own probes
+    for (auto& entry : m_neighbors)
+    {
+        if (entry.linked)
+        {
+            SetLinkStatus(Ipv4Address(entry.address), 0);
+        }
+    }
+    EnableLinkTo(neighbor);
+    m_rejoinTrace(neighbor);
+}
+
+void
+LraRoutingProtocol::SendAckRequestMessage(Ipv4Address destination)
+{
+    NS_LOG_FUNCTION(this << destination << m_nodeAddress);
+
+    // Send ack request if no other ack requst were send to this dest
+    const NeighborEntry* entry = FindNeighbor(destination);
+    if (entry && IsFresh(*entry))
+    {
+        m_ackProbesSuppressed++;
+        return;
+    }
+    if (!HasLinkTimeout(destination))
+    {
+        SendServiceMessagePacket(destination, LRA_ACK_REQUEST);
+        ArmLinkTimeout(destination);
+
+        NS_LOG_INFO("Ack Packet request send from " << m_nodeAddress << " to " << destination);
+    }
+}
+
+bool
+LraRoutingProtocol::IsFresh(const NeighborEntry& entry) const
+{
+    if (m_freshnessWindow.IsZero() || entry.confirmedTick == 0)
+    {
+        return false;
+    }
+    uint32_t window = GetTimerTick(m_freshnessWindow) >> entry.freshnessShift;
+    return GetTimerTick(Simulator::Now()) < entry.confirmedTick + window;
+}
+
+void
+LraRoutingProtocol::SendAckResponseMessage(Ipv4Address origin)
+{
+    SendServiceMessagePacket(origin, LRA_ACK_RESPONSE);
+    NS_LOG_INFO("ACK Packet response send to " << m_nodeAddress << " from " << origin);
+}
+
+void
+LraRoutingProtocol::SendHelloMessage(Ipv4Address destination)
+{
+    NS_LOG_FUNCTION(this << destination << m_nodeAddress);
+    NS_LOG_INFO("SendHelloMessage " << m_nodeAddress << " " << destination);
+
+    SendServiceMessagePacket(destination, LRA_HELLO);
+
+    initialized = true;
+}
+
+void
+LraRoutingProtocol::SendHelloResponseMessage(Ipv4Address origin)
+{
+    NS_LOG_FUNCTION(this << origin);
+    NS_LOG_INFO("SendHelloResponseMessage " << m_nodeAddress << " " << origin);
+
+    SendServiceMessagePacket(origin, LRA_HELLO_RESPONSE);
+}
+
+void
+LraRoutingProtocol::SendReversalMessage(Ipv4Address destination)
+{
+    NS_LOG_FUNCTION(this << destination << m_nodeAddress);
+    NS_LOG_INFO("SendReversalMessage " << m_nodeAddress << " " << destination);
+
+    Ptr<Packet> body = NewControlPacket();
+    body->AddHeader(
+        LraReferenceLevelHeader(m_level.tick, Ipv4Address(m_level.origin), m_level.reflected));
+    SendServiceMessagePacket(destination, LRA_REVERSAL, body);
+}
+
+void
+LraRoutingProtocol::SendDiscoveryMessage(uint32_t round)
+{
+    NS_LOG_FUNCTION(this << round);
+
+    // One broadcast carries what hello responses would have told each neighbor separately
+    LraDiscoveryHeader discovery;
+    for (const auto& entry : m_neighbors)
+    {
+        if (!entry.linked)
+        {
+            continue;
+        }
+        if (!discovery.AddLink(Ipv4Address(entry.address), entry.state))
+        {
+            NS_LOG_WARN("Node " << m_nodeAddress << " has too many neighbors for one discovery");
+            break;
+        }
+    }
+    Ptr<Packet> body = NewControlPacket();
+    body->AddHeader(discovery);
+    NS_LOG_INFO("SendDiscoveryMessage " << m_nodeAddress << " round " << round << " with "
+                                        << discovery.GetLinks().size() << " links");
+    SendServiceMessagePacket(m_broadcastAddress, LRA_DISCOVERY, body);
+
+    initialized = true;
+
+    if (round + 1 < m_discoveryRounds)
+    {
+        // Jitter keeps neighbors that started together from colliding on every round
+        Time jitter = Time(MilliSeconds(m_uniformRandomVariable->GetInteger(0, 99)));
+        m_discoveryEvent = Simulator::Schedule(m_discoveryInterval + jitter,
+                                               &LraRoutingProtocol::SendDiscoveryMessage,
+                                               this,
+                                               round + 1);
+    }
+}
+
+void
+LraRoutingProtocol::RecvDiscoveryMessage(const LraDiscoveryHeader& discovery, Ipv4Address origin)
+{
+    NS_LOG_FUNCTION(this << origin);
+
+    bool listed = false;
+    int claim = -1;
+    for (const auto& link : discovery.GetLinks())
+    {
+        if (link.first == m_nodeAddress)
+        {
+            listed = true;
+            claim = link.second;
+            break;
+        }
+    }
+
+    // The sender's claim is the opposite end of our link, otherwise fall back to the hello rule
+    if (claim == 1 || (claim == -1 && !PointsToward(origin)))
+    {
+        DisableLinkTo(origin, true);
+    }
+    else
+    {
+        EnableLinkTo(origin);
+    }
+
+    // The sender does not know us yet. Answer with a single extra broadcast, shared by every
+    // neighbor in the same situation, unless one is already due.
+    if (!listed && !m_discoveryEvent.IsPending())
+    {
+        Time jitter = Time(MilliSeconds(m_uniformRandomVariable->GetInteger(0, 99)));
+        m_discoveryEvent = Simulator::Schedule(jitter,
+                                               &LraRoutingProtocol::SendDiscoveryMessage,
+                                               this,
+                                               m_discoveryRounds);
+    }
+}
+
+void
+LraRoutingProtocol::SendServiceMessagePacket(Ipv4Address destination,
+                                             LraMessageType type,
+                                             Ptr<Packet> body)
+{
+    NS_LOG_FUNCTION(this << destination << type);
+
+    Ptr<Packet> ackPacket = body ? body : NewControlPacket();
+    LraHeader lraHeader(type, ++m_sequence);
+    lraHeader.SetCongestion(GetLocalCongestion());
+    lraHeader.SetEnergy(GetLocalEnergy());
+    if (m_mobilityAware && m_mobility)
+    {
+        lraHeader.SetMobility(m_mobility->GetPosition(), m_mobility->GetVelocity());
+    }
+    ackPacket->AddHeader(lraHeader);
+    m_ipv4->Send(ackPacket, m_nodeAddress, destination, LRA_PROTOCOL, GetRoute(destination));
+}
+
+Ptr<Ipv4Route>
+LraRoutingProtocol::GetRoute(Ipv4Address gateway, uint32_t interface)
+{
+    // Ipv4L3Protocol only reads the gateway and the device of a route it sends or forwards
+    // through, and sockets its source, so one route per neighbor serves every destination.
+    // Its destination is the neighbor, not the one of the packets it carries.
+    uint32_t address = gateway.Get();
+    auto it = std::lower_bound(m_routeCache.begin(),
+                               m_routeCache.end(),
+                               std::make_pair(address, interface),
+                               [](const CachedRoute& entry, std::pair<uint32_t, uint32_t> value) {
+                                   return std::make_pair(entry.gateway, entry.interface) < value;
+                               });
+    if (it == m_routeCache.end() || it->gateway != address || it->interface != interface)
+    {
+        Ptr<Ipv4Route> route = Create<Ipv4Route>();
+        route->SetSource(m_nodeAddress);
+        route->SetDestination(gateway);
+        route->SetGateway(gateway);
+        route->SetOutputDevice(m_ipv4->GetNetDevice(interface));
+        it = m_routeCache.insert(it, CachedRoute{address, interface, route});
+    }
+    return it->route;
+}
+
+void
+LraRoutingProtocol::InvalidateRoutes(Ipv4Address gateway)
+{
+    uint32_t address = gateway.Get();
+    m_routeCache.erase(std::remove_if(m_routeCache.begin(),
+                                      m_routeCache.end(),
+                                      [address](const CachedRoute& entry) {
+                                          return entry.gateway == address;
+                                      }),
+                       m_routeCache.end());
+}
+
+void
+LraRoutingProtocol::InvalidateRoutes()
+{
+    m_routeCache.clear();
+}
+
+Ptr<Packet>
+LraRoutingProtocol::NewControlPacket() const
+{
+    // The copy shares the tag list of the template, so the TTL tag is not built again. The
+    // Packet object and the buffer the headers go to are still allocated per message.
+    return m_controlTemplate->Copy();
+}
+
+Ipv4Address
+LraRoutingProtocol::GetNextHop()
+{
+    auto nextHop = _GetNextHop();
+    if (nextHop != m_broadcastAddress)
+    {
+        return nextHop;
+    }
+    else
+    {
+        if (nextHop == m_broadcastAddress && HasLinks())
+        {
+            ReverseLinks(false);
+            return _GetNextHop();
+        }
+    }
+
+    return m_broadcastAddress;
+}
+
+Ipv4Address
+LraRoutingProtocol::_GetNextHop()
+{
+    // Links predicted to break soon, then neighbors running out of energy, then neighbors
+    // suspected of closing a loop, are used only when nothing else is left
+    auto nextHop = _GetNextHop(false, false, false);
+    if (nextHop == m_broadcastAddress)
+    {
+        nextHop = _GetNextHop(false, false, true);
+    }
+    if (nextHop == m_broadcastAddress)
+    {
+        nextHop = _GetNextHop(false, true, true);
+    }
+    if (nextHop == m_broadcastAddress)
+    {
+        nextHop = _GetNextHop(true, true, true);
+    }
+    return nextHop;
+}
+
+Ipv4Address
+LraRoutingProtocol::_GetNextHop(bool allowSuspected, bool allowLowEnergy, bool allowShortLived)
+{
+    if (IsSink(m_nodeAddress))
+    {
+        return m_broadcastAddress;
+    }
+
+    if (m_congestionAware)
+    {
+        // Backpressure: least loaded usable neighbor, ties go to the higher address as below
+        Ipv4Address best = m_broadcastAddress;
+        int bestCongestion = 256;
+        int bestState = 0;
+        for (auto iter = m_neighbors.rbegin(); iter != m_neighbors.rend(); ++iter)
+        {
+            Ipv4Address neighbor(iter->address);
+            if (!iter->linked || neighbor == m_broadcastAddress || iter->state == 0)
+                continue;
+            if (!allowSuspected && IsSuspected(neighbor))
+                continue;
+            if (!allowLowEnergy && IsLowEnergy(neighbor))
+                continue;
+            if (!allowShortLived && IsShortLived(neighbor))
+                continue;
+            if (iter->congestion < bestCongestion)
+            {
+                best = neighbor;
+                bestCongestion = iter->congestion;
+                bestState = iter->state;
+            }
+        }
+        if (best != m_broadcastAddress && bestState == -1)
+        {
+            EnableLinkTo(best);
+        }
+        NS_LOG_FUNCTION(this << best << bestCongestion);
+        return best;
+    }
+
+    // To speed up routing is always better to deliver the packet with higher ip address.
+    for (auto iter = m_neighbors.rbegin(); iter != m_neighbors.rend(); ++iter)
+    {
+        Ipv4Address neighbor(iter->address);
+        if (!iter->linked || neighbor == m_broadcastAddress)
+            continue;
+        if (!allowSuspected && IsSuspected(neighbor))
+            continue;
+        if (!allowLowEnergy && IsLowEnergy(neighbor))
+            continue;
+        if (!allowShortLived && IsShortLived(neighbor))
+            continue;
+        if (iter->state == 1 || IsSink(m_nodeAddress))
+        {
+            NS_LOG_FUNCTION(this << neighbor);
+            return neighbor;
+        }
+        if (iter->state == -1)
+        {
+            EnableLinkTo(neighbor);
+            NS_LOG_FUNCTION(this << neighbor);
+            return neighbor;
+        }
+    }
+    NS_LOG_FUNCTION(this << m_broadcastAddress);
+
+    return m_broadcastAddress; // fallback address
+}
+
+bool
+LraRoutingProtocol::LookupForwarded(const Ipv4Header& header, Ipv4Address& nextHop)
+{
+    uint32_t source = header.GetSource().Get();
+    uint16_t identification = header.GetIdentification();
+    const auto& entry =
+        m_forwardedFilter[(source * 2654435761u ^ identification) % FORWARDED_FILTER_SIZE];
+    if (entry.source != source || entry.identification != identification ||
+        entry.expiry < Simulator::Now())
+    {
+        return false;
+    }
+    nextHop = entry.nextHop;
+    return true;
+}
+
+void
+LraRoutingProtocol::RememberForwarded(const Ipv4Header& header, Ipv4Address nextHop)
+{
+    uint32_t source = header.GetSource().Get();
+    uint16_t identification = header.GetIdentification();
+    auto& entry =
+        m_forwardedFilter[(source * 2654435761u ^ identification) % FORWARDED_FILTER_SIZE];
+    entry = ForwardedEntry{source, identification, nextHop, Simulator::Now() + m_loopDetectionWindow};
+}
+
+void
+LraRoutingProtocol::SuspectLoop(Ipv4Address neighbor)
+{
+    GetNeighbor(neighbor).suspectedUntil = GetTimerTick(Simulator::Now() + m_loopSuspicionTimeout);
+    m_loopTrace(neighbor);
+}
+
+bool
+LraRoutingProtocol::IsSuspected(Ipv4Address neighbor)
+{
+    // The suspicion expires once the topology had time to change
+    const NeighborEntry* entry = FindNeighbor(neighbor);
+    return entry && GetTimerTick(Simulator::Now()) < entry->suspectedUntil;
+}
+
+uint8_t
+LraRoutingProtocol::GetLocalCongestion() const
+{
+    uint32_t length = 0;
+    uint32_t capacity = 0;
+    Ptr<NetDevice> device = m_ipv4->GetNetDevice(1);
+    if (Ptr<WifiNetDevice> wifi = DynamicCast<WifiNetDevice>(device))
+    {
+        // Data and LRA messages all go through the best effort access category
+        Ptr<WifiMacQueue> queue = wifi->GetMac()->GetTxopQueue(AC_BE);
+        if (queue)
+        {
+            length = queue->GetNPackets();
+            capacity = queue->GetMaxSize().GetValue();
+        }
+    }
+    else if (Ptr<SimpleNetDevice> simple = DynamicCast<SimpleNetDevice>(device))
+    {
+        Ptr<Queue<Packet>> queue = simple->GetQueue();
+        if (queue)
+        {
+            length = queue->GetNPackets();
+            capacity = queue->GetMaxSize().GetValue();
+        }
+    }
+    if (capacity == 0)
+    {
+        return 0;
+    }
+    return static_cast<uint8_t>(std::min<uint64_t>(255, uint64_t(length) * 255 / capacity));
+}
+
+uint8_t
+LraRoutingProtocol::GetNeighborCongestion(Ipv4Address neighbor) const
+{
+    const NeighborEntry* entry = FindNeighbor(neighbor);
+    return entry ? entry->congestion : 0;
+}
+
+uint8_t
+LraRoutingProtocol::GetLocalEnergy() const
+{
+    if (m_energyLevel.IsNull())
+    {
+        return 255;
+    }
+    double level = std::clamp(m_energyLevel(), 0.0, 1.0);
+    return static_cast<uint8_t>(std::lround(level * 255));
+}
+
+bool
+LraRoutingProtocol::IsLowEnergy(Ipv4Address neighbor) const
+{
+    if (m_lowEnergyThreshold <= 0)
+    {
+        return false;
+    }
+    const NeighborEntry* entry = FindNeighbor(neighbor);
+    return entry && entry->energy < m_lowEnergyThreshold * 255;
+}
+
+void
+LraRoutingProtocol::UpdateNeighborMotion(Ipv4Address neighbor, const LraHeader& header)
+{
+    uint32_t address = neighbor.Get();
+    auto it = std::lower_bound(m_neighborMotion.begin(),
+                               m_neighborMotion.end(),
+                               address,
+                               [](const NeighborMotion& motion, uint32_t value) {
+                                   return motion.address < value;
+                               });
+    if (it == m_neighborMotion.end() || it->address != address)
+    {
+        it = m_neighborMotion.insert(it, NeighborMotion{address, 0, {0, 0}, {0, 0}});
+    }
+    Vector position = header.GetPosition();
+    Vector velocity = header.GetVelocity();
+    it->heardTick = GetTimerTick(Simulator::Now());
+    it->position[0] = position.x;
+    it->position[1] = position.y;
+    it->velocity[0] = velocity.x;
+    it->velocity[1] = velocity.y;
+}
+
+Time
+LraRoutingProtocol::GetLinkLifetime(Ipv4Address neighbor) const
+{
+    uint32_t address = neighbor.Get();
+    auto it = std::lower_bound(m_neighborMotion.begin(),
+                               m_neighborMotion.end(),
+                               address,
+                               [](const NeighborMotion& motion, uint32_t value) {
+                                   return motion.address < value;
+                               });
+    if (!m_mobility || it == m_neighborMotion.end() || it->address != address)
+    {
+        return Time::Max(); // nothing to predict from
+    }
+
+    // Neighbor position extrapolated to now, relative to this node
+    Time heard = TimeStep(m_timerResolution.GetTimeStep() * it->heardTick);
+    double age = (Simulator::Now() - heard).GetSeconds();
+    Vector position = m_mobility->GetPosition();
+    Vector velocity = m_mobility->GetVelocity();
+    double dx = it->position[0] + it->velocity[0] * age - position.x;
+    double dy = it->position[1] + it->velocity[1] * age - position.y;
+    double vx = it->velocity[0] - velocity.x;
+    double vy = it->velocity[1] - velocity.y;
+
+    // Positive root of |d + v t| = range, assuming both keep their velocity
+    double c = dx * dx + dy * dy - m_linkRange * m_linkRange;
+    if (c >= 0)
+    {
+        return Seconds(0);
+    }
+    double v2 = vx * vx + vy * vy;
+    if (v2 == 0)
+    {
+        return Time::Max();
+    }
+    double b = dx * vx + dy * vy;
+    return Seconds((-b + std::sqrt(b * b - v2 * c)) / v2);
+}
+
+bool
+LraRoutingProtocol::IsShortLived(Ipv4Address neighbor) const
+{
+    return m_mobilityAware && GetLinkLifetime(neighbor) < m_linkLifetimeThreshold;
+}
+
+bool
+LraRoutingProtocol::HasNextHop()
+{
+    return _GetNextHop() != m_broadcastAddress; // fallback address
+}
+
+void
+LraRoutingProtocol::EnqueueForAggregation(Ptr<const Packet> p, const Ipv4Header& header)
+{
+    NS_LOG_FUNCTION(this << p->GetUid());
+
+    uint32_t size = p->GetSize() + header.GetSerializedSize();
+    if (m_aggregateBytes + size > m_aggregationMaxSize)
+    {
+        FlushAggregate();
+    }
+
+    // What IpForward would have done on the way out
+    Ipv4Header forwarded = header;
+    forwarded.SetTtl(header.GetTtl() - 1);
+    m_aggregateQueue.push_back(AggregatedPacket{p->Copy(), forwarded});
+    m_aggregateBytes += size;
+
+    if (!m_aggregateEvent.IsPending())
+    {
+        m_aggregateEvent =
+            Simulator::Schedule(m_aggregationWindow, &LraRoutingProtocol::FlushAggregate, this);
+    }
+}
+
+void
+LraRoutingProtocol::FlushAggregate()
+{
+    NS_LOG_FUNCTION(this << m_aggregateQueue.size());
+
+    m_aggregateEvent.Cancel();
+    if (m_aggregateQueue.empty())
+    {
+        return;
+    }
+
+    std::vector<AggregatedPacket> queue;
+    queue.swap(m_aggregateQueue);
+    m_aggregateBytes = 0;
+
+    auto neighbor = GetNextHop();
+    if (neighbor == m_broadcastAddress)
+    {
+        NS_LOG_INFO("No route for " << queue.size() << " aggregated packets.");
+        for (const auto& entry : queue)
+        {
+            m_dropTrace(entry.payload, entry.header, LraDropReason::NoRoute);
+        }
+        return;
+    }
+
+    LraAggregateHeader aggregate;
+    Ptr<Packet> body = NewControlPacket();
+    for (const auto& entry : queue)
+    {
+        Ptr<Packet> datagram = entry.payload->Copy();
+        datagram->AddHeader(entry.header);
+        aggregate.AddLength(datagram->GetSize());
+        body->AddAtEnd(datagram);
+
+        RememberForwarded(entry.header, neighbor);
+        m_forwardTrace(entry.payload, entry.header, neighbor);
+    }
+    body->AddHeader(aggregate);
+    NS_LOG_INFO("Aggregate of " << queue.size() << " packets sent from " << m_nodeAddress
+                                << " to " << neighbor);
+    SendServiceMessagePacket(neighbor, LRA_AGGREGATE, body);
+    m_aggregateFrames++;
+    m_aggregatedPackets += queue.size();
+
+    SendAckRequestMessage(neighbor);
+}
+
+void
+LraRoutingProtocol::RecvAggregate(Ptr<const Packet> p,
+                                  Ipv4Address origin,
+                                  Ptr<const NetDevice> idev,
+                                  const UnicastForwardCallback& ucb,
+                                  const MulticastForwardCallback& mcb,
+                                  const LocalDeliverCallback& lcb,
+                                  const ErrorCallback& ecb)
+{
+    Ptr<Packet> frame = p->Copy();
+    LraHeader lraHeader;
+    LraAggregateHeader aggregate;
+    frame->RemoveHeader(lraHeader);
+    frame->RemoveHeader(aggregate);
+    NS_LOG_INFO("Aggregate of " << aggregate.GetLengths().size() << " packets delivered to "
+                                << m_nodeAddress << " from " << origin);
+
+    uint32_t offset = 0;
+    for (uint16_t length : aggregate.GetLengths())
+    {
+        if (offset + length > frame->GetSize())
+        {
+            NS_LOG_WARN("Truncated aggregate from " << origin);
+            break;
+        }
+        Ptr<Packet> datagram = frame->CreateFragment(offset, length);
+        offset += length;
+
+        Ipv4Header header;
+        datagram->RemoveHeader(header);
+        // Tags of the frame are not the ones of the inner packet, only the previous hop is known
+        datagram->RemoveAllPacketTags();
+        LraPreviousHopTag tag(origin);
+        datagram->AddPacketTag(tag);
+        RouteInput(datagram, header, idev, ucb, mcb, lcb, ecb);
+    }
+}
+
+void
+LraRoutingProtocol::LearnReverseRoute(Ptr<const Packet> p, const Ipv4Header& header)
+{
+    LraPreviousHopTag tag;
+    Ipv4Address previousHop = p->PeekPacketTag(tag) ? tag.GetPreviousHop() : header.GetSource();
+    uint32_t source = header.GetSource().Get();
+    auto it = std::lower_bound(m_reverseRoutes.begin(),
+                               m_reverseRoutes.end(),
+                               source,
+                               [](const ReverseRoute& route, uint32_t value) {
+                                   return route.source < value;
+                               });
+    Time now = Simulator::Now();
+    if (it == m_reverseRoutes.end() || it->source != source)
+    {
+        // New sources are the only way the table grows: drop the expired routes first
+        auto expired = std::remove_if(m_reverseRoutes.begin(),
+                                      m_reverseRoutes.end(),
+                                      [now](const ReverseRoute& route) {
+                                          return route.expiry <= now;
+                                      });
+        m_reverseRoutes.erase(expired, m_reverseRoutes.end());
+        it = std::lower_bound(m_reverseRoutes.begin(),
+                              m_reverseRoutes.end(),
+                              source,
+                              [](const ReverseRoute& route, uint32_t value) {
+                                  return route.source < value;
+                              });
+        it = m_reverseRoutes.insert(it, ReverseRoute{source, 0, Time(0)});
+    }
+    it->nextHop = previousHop.Get();
+    it->expiry = now + m_reverseRouteLifetime;
+}
+
+bool
+LraRoutingProtocol::LookupReverseRoute(Ipv4Address destination, Ipv4Address& nextHop)
+{
+    uint32_t source = destination.Get();
+    auto it = std::lower_bound(m_reverseRoutes.begin(),
+                               m_reverseRoutes.end(),
+                               source,
+                               [](const ReverseRoute& route, uint32_t value) {
+                                   return route.source < value;
+                               });
+    // Expired entries are removed when the next source is learned
+    Time now = Simulator::Now();
+    if (it == m_reverseRoutes.end() || it->source != source || it->expiry <= now)
+    {
+        return false;
+    }
+    it->expiry = now + m_reverseRouteLifetime;
+    nextHop = Ipv4Address(it->nextHop);
+    return true;
+}
+
+void
+LraRoutingProtocol::PurgeReverseRoutes(Ipv4Address nextHop)
+{
+    uint32_t address = nextHop.Get();
+    m_reverseRoutes.erase(std::remove_if(m_reverseRoutes.begin(),
+                                         m_reverseRoutes.end(),
+                                         [address](const ReverseRoute& route) {
+                                             return route.nextHop == address;
+                                         }),
+                          m_reverseRoutes.end());
+}
+
+Ptr<Packet>
+LraRoutingProtocol::TagForwarded(Ptr<const Packet> p) const
+{
+    Ptr<Packet> packet = p->Copy();
+    LraPreviousHopTag tag(m_nodeAddress);
+    packet->ReplacePacketTag(tag);
+    return packet;
+}
+
+bool
+LraRoutingProtocol::IsDuplicate(Ipv4Address origin, uint32_t sequence)
+{
+    uint32_t address = origin.Get();
+    auto& entry = m_duplicateCache[(address * 2654435761u ^ sequence) % DUPLICATE_CACHE_SIZE];
+    Time now = Simulator::Now();
+    if (entry.origin == address && entry.sequence == sequence && entry.expiry >= now)
+    {
+        return true;
+    }
+    entry = DuplicateEntry{address, sequence, now + m_duplicateCacheLifetime};
+    return false;
+}
+
+RecvLraStatus
+LraRoutingProtocol::RecvLraServiceMessage(const LraHeader& lraHeader,
+                                          Ptr<const Packet> packet,
+                                          Ipv4Address origin)
+{
+    // Ack request received
+    if (lraHeader.GetType() == LRA_ACK_REQUEST)
+    {
+        NS_LOG_INFO("ACK Packet request delivered to " << m_nodeAddress << " from " << origin);
+        DisableLinkTo(origin);
+        if (GetNeighbor(origin).state == 1)
+        {
+            // Both ends claim the link as outgoing: a two-node loop
+            NS_LOG_INFO("Cycle between " << m_nodeAddress << " from " << origin);
+            SuspectLoop(origin);
+            return RecvLraStatus::Error;
+        }
+        SendAckResponseMessage(origin);
+    }
+    // Ack response received
+    else if (lraHeader.GetType() == LRA_ACK_RESPONSE)
+    {
+        NS_LOG_INFO("ACK Packet response delivered to " << m_nodeAddress << " from " << origin);
+        EnableLinkTo(origin); // link is active, cancels the timeout
+        NeighborEntry& entry = GetNeighbor(origin);
+        entry.confirmedTick = GetTimerTick(Simulator::Now());
+        if (entry.freshnessShift > 0)
+        {
+            entry.freshnessShift--;
+        }
+
+    }
+    // Hello message received
+    else if (lraHeader.GetType() == LRA_HELLO)
+    {
+        NS_LOG_INFO("Hello Packet delivered to " << m_nodeAddress << " from " << origin);
+        if (PointsToward(origin))
+        {
+            EnableLinkTo(origin);
+        }
+        else
+        {
+            DisableLinkTo(origin, true);
+        }
+
+        int randJitter = m_uniformRandomVariable->GetInteger(0, 999);
+        Time jitter = Time(MilliSeconds(randJitter));
+        Simulator::Schedule(jitter,
+                            &LraRoutingProtocol::SendHelloResponseMessage,
+                            this,
+                            origin);
+    }
+    // Hello message response received
+    else if (lraHeader.GetType() == LRA_HELLO_RESPONSE)
+    {
+        NS_LOG_INFO("Hello Packet response delivered to " << m_nodeAddress << " from "
+                                                            << origin);
+        if (PointsToward(origin))
+        {
+            EnableLinkTo(origin);
+        }
+        else
+        {
+            DisableLinkTo(origin, true);
+        }
+    }
+    // Set passive response received
+    else if (lraHeader.GetType() == LRA_REVERSAL)
+    {
+        if (m_partitionDetection)
+        {
+            ReferenceLevel level = ReadLevel(packet);
+            SetNeighborLevel(origin, level);
+            if (level == m_level)
+            {
+                // The sender is at our level and kept its link toward us
+                return RecvLraStatus::Service;
+            }
+        }
+        DisableLinkTo(origin);
+    }
+    // A member of our component found it cut off from the sink
+    else if (lraHeader.GetType() == LRA_PARTITION)
+    {
+        ReferenceLevel level = ReadLevel(packet);
+        if (m_partitionDetection && !m_partitioned && !IsSink(m_nodeAddress) &&
+            level.tick == m_level.tick && level.origin == m_level.origin)
+        {
+            EnterPartition(level);
+        }
+    }
+    // A partitioned neighbor looks for a path to the sink
+    else if (lraHeader.GetType() == LRA_REJOIN)
+    {
+        if (!m_partitioned)
+        {
+            // The prober will forward through this node
+            DisableLinkTo(origin, true);
+            if (IsSink(m_nodeAddress) || HasNextHop())
+            {
+                SendServiceMessagePacket(origin, LRA_REJOIN_RESPONSE);
+            }
+        }
+    }
+    else if (lraHeader.GetType() == LRA_REJOIN_RESPONSE)
+    {
+        if (m_partitioned)
+        {
+            Rejoin(origin);
+        }
+    }
+    // Aggregated discovery received
+    else if (lraHeader.GetType() == LRA_DISCOVERY)
+    {
+        NS_LOG_INFO("Discovery Packet delivered to " << m_nodeAddress << " from " << origin);
+        Ptr<Packet> copy = packet->Copy();
+        LraHeader header;
+        LraDiscoveryHeader discovery;
+        copy->RemoveHeader(header);
+        copy->RemoveHeader(discovery);
+        RecvDiscoveryMessage(discovery, origin);
+    }
+    else{
+        return RecvLraStatus::NotService;
+    }
+    return RecvLraStatus::Service;
+}
+
+void
+LraRoutingProtocol::PrintRoutingTable(Ptr<OutputStreamWrapper> stream, Time::Unit unit) const
+{
+    NS_LOG_FUNCTION(this);
+    for (const auto& entry : m_neighbors)
+    {
+        if (entry.linked)
+        {
+            *stream->GetStream() << m_nodeAddress << "\t" << Ipv4Address(entry.address) << "\t"
+                                 << int(entry.state) << std::endl;
+        }
+    }
+}
+
+std::vector<std::pair<Ipv4Address, int>>
+LraRoutingProtocol::GetLinkStates() const
+{
+    std::vector<std::pair<Ipv4Address, int>> links;
+    links.reserve(m_neighbors.size());
+    for (const auto& entry : m_neighbors)
+    {
+        if (entry.linked)
+        {
+            links.emplace_back(Ipv4Address(entry.address), entry.state);
+        }
+    }
+    return links;
+}
+
+void
+LraRoutingProtocol::SaveState(LraCheckpointNode& state) const
+{
+    state.record.address = m_nodeAddress.Get();
+    state.record.sequence = m_sequence;
+    state.record.controlReceived = m_controlReceived;
+    state.record.duplicatesSuppressed = m_duplicatesSuppressed;
+    state.links.clear();
+    state.links.reserve(m_neighbors.size());
+    for (const auto& entry : m_neighbors)
+    {
+        if (entry.linked)
+        {
+            state.links.push_back(LraCheckpointLink{entry.address, entry.state});
+        }
+    }
+    state.record.linkCount = state.links.size();
+}
+
+void
+LraRoutingProtocol::RestoreState(const std::vector<Ipv4Address>& sinks,
+                                 int index,
+                                 const LraCheckpointNode& state)
+{
+    NS_LOG_FUNCTION(this << sinks.size() << index);
+
+    std::vector<std::pair<Ipv4Address, int>> links;
+    links.reserve(state.links.size());
+    for (const auto& link : state.links)
+    {
+        links.emplace_back(Ipv4Address(link.neighbor), link.state);
+    }
+    WarmStart(sinks, index, links);
+
+    // Counters go on from the checkpoint, totals then match a run that did the bootstrap
+    m_sequence = state.record.sequence;
+    m_controlReceived = state.record.controlReceived;
+    m_duplicatesSuppressed = state.record.duplicatesSuppressed;
+}
+
+uint32_t
+LraRoutingProtocol::GetControlMessagesReceived() const
+{
+    return m_controlReceived;
+}
+
+uint32_t
+LraRoutingProtocol::GetDuplicatesSuppressed() const
+{
+    return m_duplicatesSuppressed;
+}
+
+uint32_t
+LraRoutingProtocol::GetAggregateFramesSent() const
+{
+    return m_aggregateFrames;
+}
+
+uint32_t
+LraRoutingProtocol::GetAggregatedPackets() const
+{
+    return m_aggregatedPackets;
+}
+
+uint32_t
+LraRoutingProtocol::GetReversals() const
+{
+    return m_reversals;
+}
+
+uint32_t
+LraRoutingProtocol::GetAckProbesSuppressed() const
+{
+    return m_ackProbesSuppressed;
+}
+
+uint32_t
+LraRoutingProtocol::GetPartitions() const
+{
+    return m_partitions;
+}
+
+uint32_t
+LraRoutingProtocol::GetRejoins() const
+{
+    return m_rejoins;
+}
+
+bool
+LraRoutingProtocol::IsDetached() const
+{
+    return m_detached;
+}
+
+void
+LraRoutingProtocol::NotifyNeighborLost(Ipv4Address neighbor)
+{
+    NS_LOG_FUNCTION(this << neighbor);
+
+    NeighborEntry* entry = FindNeighbor(neighbor);
+    if (m_detached || !entry || !entry->linked)
+    {
+        return;
+    }
+    NS_LOG_INFO("Node " << m_nodeAddress << " lost its link to " << neighbor);
+    int oldStatus = entry->state;
+    entry->linked = false;
+    CancelLinkTimeout(neighbor);
+    InvalidateRoutes(neighbor);
+    PurgeReverseRoutes(neighbor);
+    m_linkStateTrace(neighbor, oldStatus, -1);
+
+    if (oldStatus == 1 && !IsSink(m_nodeAddress) && !HasNextHop())
+    {
+        ReverseLinks(true);
+    }
+}
+
+void
+LraRoutingProtocol::NotifyNeighborFound(Ipv4Address neighbor)
+{
+    NS_LOG_FUNCTION(this << neighbor);
+
+    if (!m_detached)
+    {
+        // Same rule as at startup, the neighbor answers with a hello response
+        SendHelloMessage(neighbor);
+    }
+}
+
+bool
+LraRoutingProtocol::IsPartitioned() const
+{
+    return m_partitioned;
+}
+
+void
+LraRoutingProtocol::SetEnergyLevelCallback(Callback<double> energyLevel)
+{
+    m_energyLevel = energyLevel;
+}
+
+LraRoutingProtocol::MemoryUsage
+LraRoutingProtocol::GetMemoryUsage() const
+{
+    MemoryUsage usage;
+    usage.object = sizeof(*this);
+    usage.neighbors = m_neighbors.capacity() * sizeof(NeighborEntry) +
+                      m_neighborMotion.capacity() * sizeof(NeighborMotion) +
+                      m_neighborLevels.capacity() * sizeof(NeighborLevel) +
+                      m_routeCache.capacity() * sizeof(CachedRoute) +
+                      m_routeCache.size() * sizeof(Ipv4Route);
+    usage.reverseRoutes = m_reverseRoutes.capacity() * sizeof(ReverseRoute);
+    usage.linkTimers = m_timerWheel.capacity() * sizeof(std::vector<uint32_t>);
+    for (const auto& slot : m_timerWheel)
+    {
+        usage.linkTimers += slot.capacity() * sizeof(uint32_t);
+    }
+    usage.aggregation = m_aggregateQueue.capacity() * sizeof(AggregatedPacket);
+    return usage;
 }
 
 float 
@@ -523,6 +2014,12 @@ LraRoutingProtocol::NotifyInterfaceUp(uint32_t i)
     Ipv4InterfaceAddress iface = l3->GetAddress(1, 0);
     m_broadcastAddress = iface.GetBroadcast();
     m_nodeAddress = iface.GetLocal();
+    // Cached routes carry the old source address and device
+    InvalidateRoutes();
+    if (i == 1 && m_detached)
+    {
+        Reattach();
+    }
 }
 
 void
@@ -530,6 +2027,15 @@ LraRoutingProtocol::NotifyInterfaceDown(uint32_t i)
 {
     NS_LOG_FUNCTION(this << i);
     NS_LOG_INFO("NotifyInterfaceDown " << i);
+    InvalidateRoutes();
+    if (i == 1 && !m_detached)
+    {
+        // Every link went through this interface. Nothing can be sent any more: the neighbors
+        // learn it from their link layer (NotifyNeighborLost) or their ACK timeouts, and
+        // reverse if this was their last way out.
+        ClearRoutingState();
+        m_detached = true;
+    }
 }
 
 void
@@ -537,6 +2043,13 @@ LraRoutingProtocol::NotifyAddAddress(uint32_t i, Ipv4InterfaceAddress address)
 {
     NS_LOG_FUNCTION(this << i << address);
     NS_LOG_INFO("NotifyAddAddress " << i << " address:" << address);
+    InvalidateRoutes();
+    if (i == 1 && m_detached && m_ipv4->IsUp(i))
+    {
+        m_nodeAddress = address.GetLocal();
+        m_broadcastAddress = address.GetBroadcast();
+        Reattach();
+    }
 }
 
 void
@@ -544,12 +2057,20 @@ LraRoutingProtocol::NotifyRemoveAddress(uint32_t i, Ipv4InterfaceAddress address
 {
     NS_LOG_FUNCTION(this << i << address);
     NS_LOG_INFO("NotifyRemoveAddress " << i << " address:" << address);
+    InvalidateRoutes();
+    if (i == 1 && address.GetLocal() == m_nodeAddress && !m_detached)
+    {
+        // The neighbors know this node by the removed address
+        ClearRoutingState();
+        m_detached = true;
+    }
 }
 
 int64_t
 LraRoutingProtocol::AssignStreams(int64_t stream)
 {
     NS_LOG_FUNCTION(this << stream);
+    m_uniformRandomVariable->SetStream(stream);
     return 1;
 }
 
@@ -1,14 +1,20 @@
 #ifndef LRA_ROUTING_PROTOCOL_H
 #define LRA_ROUTING_PROTOCOL_H
 
+#include "lra-checkpoint.h"
+#include "lra-packet.h"
+
 #include "ns3/ipv4-routing-protocol.h"
+#include "ns3/mobility-model.h"
 #include "ns3/node.h"
 #include "ns3/ipv4-address.h"
 #include "ns3/header.h"
 #include "ns3/nstime.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/traced-callback.h"
 #include "algorithm"
-#include <map>
-#include <set>
+#include <array>
+#include <vector>
 #include <iostream>
 #include <fstream>
 #include <chrono>
@@ -21,15 +27,35 @@ enum RecvLraStatus{
   Error
 };
 
+/// Why a packet was not forwarded
+enum LraDropReason{
+  NoRoute,
+  InterfaceDown ///< Queued for aggregation when the interface went down
+};
+
 class LraRoutingProtocol : public Ipv4RoutingProtocol {
 public:
   static TypeId GetTypeId (void);
   static const uint32_t LRA_PORT;
-  static const char * LRA_ACK_SEND_MESSAGE;
-  static const char * LRA_ACK_RECV_MESSAGE;
-  static const char * LRA_HELLO_RECV_MESSAGE;
-  static const char * LRA_HELLO_SEND_MESSAGE;
-  static const char * LRA_REVERSAL_SEND_MESSAGE;
+  /// IP protocol number of LRA control messages (RFC 3692 experimentation value)
+  static const uint8_t LRA_PROTOCOL;
+
+  /// TracedCallback signature for link orientation changes (-1 = unknown, 0 = incoming, 1 = outgoing)
+  typedef void (*LinkStateTracedCallback)(Ipv4Address neighbor, int oldState, int newState);
+  /// TracedCallback signature for full link reversals
+  typedef void (*ReversalTracedCallback)(uint32_t reversedLinks);
+  /// TracedCallback signature for forwarded packets
+  typedef void (*ForwardTracedCallback)(Ptr<const Packet> packet, const Ipv4Header &header,
+                                        Ipv4Address nextHop);
+  /// TracedCallback signature for detected forwarding loops
+  typedef void (*LoopTracedCallback)(Ipv4Address suspect);
+  /// TracedCallback signature for dropped packets
+  typedef void (*DropTracedCallback)(Ptr<const Packet> packet, const Ipv4Header &header,
+                                     LraDropReason reason);
+  /// TracedCallback signature for partitions, origin is the node that detected it
+  typedef void (*PartitionTracedCallback)(Ipv4Address origin);
+  /// TracedCallback signature for rejoins, neighbor is the connected node that answered
+  typedef void (*RejoinTracedCallback)(Ipv4Address neighbor);
 
   /// c-tor
   LraRoutingProtocol ();
@@ -58,39 +84,339 @@ public:
 
   virtual void SetIpv4(Ptr<Ipv4> ipv4);
   // Custom methods:
-  void InitializeNode(Ipv4Address sinkAddress, int index);
+  /**
+   * Start the discovery phase.
+   * \param sinks addresses of the sinks, all roots of the DAG. They form one anycast
+   *        destination addressed by the first one: any sink delivers the packets locally.
+   * \param index index of the node based on creation
+   */
+  void InitializeNode(const std::vector<Ipv4Address> &sinks, int index);
+  /**
+   * Skip the discovery phase: adopt the given links and start routing at once.
+   * \param sinks addresses of the sinks, as for InitializeNode
+   * \param index index of the node based on creation
+   * \param links neighbors with their orientation (0 = incoming, 1 = outgoing)
+   */
+  void WarmStart(const std::vector<Ipv4Address> &sinks, int index,
+                 const std::vector<std::pair<Ipv4Address, int>> &links);
   float GetAverageHopCount();
+  /// Links known by this node with their orientation (-1 = unknown, 0 = incoming, 1 = outgoing)
+  std::vector<std::pair<Ipv4Address, int>> GetLinkStates() const;
+  /// Copy links and counters into a checkpoint entry, the position is left to the caller
+  void SaveState(LraCheckpointNode &state) const;
+  /// Restore links and counters from a checkpoint entry and start routing at once
+  void RestoreState(const std::vector<Ipv4Address> &sinks, int index,
+                    const LraCheckpointNode &state);
   int64_t AssignStreams(int64_t stream);
+  /// Number of control messages processed
+  uint32_t GetControlMessagesReceived() const;
+  /// Number of duplicate control messages discarded before processing
+  uint32_t GetDuplicatesSuppressed() const;
+  /// Number of aggregate frames sent
+  uint32_t GetAggregateFramesSent() const;
+  /// Number of packets carried by the aggregate frames sent
+  uint32_t GetAggregatedPackets() const;
+  /// Number of full link reversals performed
+  uint32_t GetReversals() const;
+  /// Number of ACK probes skipped because the next hop was confirmed recently
+  uint32_t GetAckProbesSuppressed() const;
+  /// Number of times this node found itself cut off from the sink
+  uint32_t GetPartitions() const;
+  /// Number of times this node reached the sink again after a partition
+  uint32_t GetRejoins() const;
+  /// Whether the node is cut off from the sink and waits for a connected neighbor
+  bool IsPartitioned() const;
+  /**
+   * Set the source of the remaining energy of this node, as a fraction of the
+   * initial one. Nodes without it advertise a full battery.
+   */
+  void SetEnergyLevelCallback(Callback<double> energyLevel);
+  /// Whether the interface went down or lost its address and the node waits to rediscover
+  bool IsDetached() const;
+  /**
+   * Link layer notice that a neighbor can no longer be reached, e.g. its interface
+   * went down. The link is removed at once and, if it was the last way out, the
+   * node reverses instead of waiting for an ACK timeout.
+   */
+  void NotifyNeighborLost(Ipv4Address neighbor);
+  /// Link layer notice that a neighbor is reachable again: the link is set up with a hello
+  void NotifyNeighborFound(Ipv4Address neighbor);
+
+  /// Heap and object bytes held by the routing state, by component
+  struct MemoryUsage
+  {
+    uint64_t object = 0; // The protocol object, fixed-size caches included
+    uint64_t neighbors = 0; // Neighbor table
+    uint64_t reverseRoutes = 0; // Reverse route table
+    uint64_t linkTimers = 0; // Timer wheel of the link timeouts
+    uint64_t aggregation = 0; // Aggregation queue, packets excluded
+  };
+  /// \return the memory held by the routing state of this node
+  MemoryUsage GetMemoryUsage() const;
 
 private:
+  /// Reference level of a wave of reversals, see LraReferenceLevelHeader
+  struct ReferenceLevel
+  {
+    uint32_t tick = 0; // Timer tick of the link failure
+    uint32_t origin = 0; // Node that lost its last outgoing link, 0 for no level
+    bool reflected = false; // The wave travels back toward its origin
+    bool operator< (const ReferenceLevel &other) const;
+    bool operator== (const ReferenceLevel &other) const;
+  };
+
   void LinkReversal();
+  /**
+   * Reverse the links after losing the last outgoing one. With partition detection
+   * the reversal carries a reference level, and a node whose neighbors all reflected
+   * its own level is cut off from the sink.
+   * \param linkFailure the last outgoing link timed out, which starts a new level
+   */
+  void ReverseLinks(bool linkFailure);
+  ReferenceLevel GetNeighborLevel(Ipv4Address neighbor) const;
+  void SetNeighborLevel(Ipv4Address neighbor, const ReferenceLevel &level);
+  /// Level carried by a reversal or partition message
+  ReferenceLevel ReadLevel(Ptr<const Packet> packet) const;
+  /// Schedule the first hello or discovery broadcast
+  void StartDiscovery(Time jitter);
+  /**
+   * Forget every link, timer, route and queued packet. Called when the interface goes
+   * down: the links through it are gone, there is no point in waiting for ACK timeouts.
+   */
+  void ClearRoutingState();
+  /// Interface usable again: rediscover the neighbors as a new node would
+  void Reattach();
+  /// Stop reversing, tell the component and probe for a connected neighbor
+  void EnterPartition(const ReferenceLevel &level);
+  void SendRejoinMessage();
+  /// Leave the partition through a neighbor connected to the sink
+  void Rejoin(Ipv4Address neighbor);
   void SendHelloMessage (Ipv4Address destination);
   void SendAckRequestMessage (Ipv4Address destination);
   void SendHelloResponseMessage (Ipv4Address origin);
   void SendAckResponseMessage (Ipv4Address origin);
-  void SendServiceMessagePacket(Ipv4Address destination, const char* type);
+  /**
+   * Send a control message to a neighbor or to all of them.
+   * \param destination neighbor address or the broadcast address
+   * \param type message type
+   * \param body message body, built on NewControlPacket; nullptr for none
+   */
+  void SendServiceMessagePacket(Ipv4Address destination, LraMessageType type,
+                                Ptr<Packet> body = nullptr);
   void SendReversalMessage (Ipv4Address destination);
-  RecvLraStatus RecvLraServiceMessage(std::string payload, Ipv4Address origin);
-  void DisableLinkTo(Ipv4Address destination, bool avoidReverse = false);
+  void SendDiscoveryMessage (uint32_t round);
+  void RecvDiscoveryMessage (const LraDiscoveryHeader &discovery, Ipv4Address origin);
+  void EnqueueForAggregation(Ptr<const Packet> p, const Ipv4Header &header);
+  void FlushAggregate();
+  void RecvAggregate(Ptr<const Packet> p, Ipv4Address origin, Ptr<const NetDevice> idev,
+                     const UnicastForwardCallback &ucb, const MulticastForwardCallback &mcb,
+                     const LocalDeliverCallback &lcb, const ErrorCallback &ecb);
+  RecvLraStatus RecvLraServiceMessage(const LraHeader &lraHeader, Ptr<const Packet> packet,
+                                      Ipv4Address origin);
+  bool IsDuplicate(Ipv4Address origin, uint32_t sequence);
+  void DisableLinkTo(Ipv4Address destination, bool avoidReverse = false, bool linkFailure = false);
   void EnableLinkTo(Ipv4Address destination);
   void InitLinkTo(Ipv4Address destination);
+  void SetLinkStatus(Ipv4Address neighbor, int status);
+  bool HasLinks() const;
+  uint32_t GetTimerTick(Time time) const;
+  void ArmLinkTimeout(Ipv4Address neighbor);
+  void CancelLinkTimeout(Ipv4Address neighbor);
+  bool HasLinkTimeout(Ipv4Address neighbor) const;
+  void AdvanceTimerWheel();
   Ipv4Address GetNextHop();
   Ipv4Address _GetNextHop();
+  Ipv4Address _GetNextHop(bool allowSuspected, bool allowLowEnergy, bool allowShortLived);
+  bool LookupForwarded(const Ipv4Header &header, Ipv4Address &nextHop);
+  void RememberForwarded(const Ipv4Header &header, Ipv4Address nextHop);
+  void SuspectLoop(Ipv4Address neighbor);
+  bool IsSuspected(Ipv4Address neighbor);
   bool HasNextHop();
-  std::string GetPacketPayload(Ptr<const Packet> p);
+  uint8_t GetLocalCongestion() const;
+  uint8_t GetNeighborCongestion(Ipv4Address neighbor) const;
+  uint8_t GetLocalEnergy() const;
+  bool IsLowEnergy(Ipv4Address neighbor) const;
+  void UpdateNeighborMotion(Ipv4Address neighbor, const LraHeader &header);
+  Time GetLinkLifetime(Ipv4Address neighbor) const;
+  bool IsShortLived(Ipv4Address neighbor) const;
+  void LearnReverseRoute(Ptr<const Packet> p, const Ipv4Header &header);
+  bool LookupReverseRoute(Ipv4Address destination, Ipv4Address &nextHop);
+  /// Drop the reverse routes through a neighbor whose link failed
+  void PurgeReverseRoutes(Ipv4Address nextHop);
+  Ptr<Packet> TagForwarded(Ptr<const Packet> p) const;
+  /// Route through a neighbor, created on first use and shared by every packet sent that way.
+  /// Its destination is the neighbor itself, whatever the destination of the packet.
+  Ptr<Ipv4Route> GetRoute(Ipv4Address gateway, uint32_t interface = 1);
+  /// Drop the cached routes through a neighbor, e.g. when its link is removed
+  void InvalidateRoutes(Ipv4Address gateway);
+  /// Drop every cached route, e.g. when an interface or address changes
+  void InvalidateRoutes();
+  /// Empty control packet with its TTL tag, a copy-on-write copy of m_controlTemplate
+  Ptr<Packet> NewControlPacket() const;
+  void SetSinks(const std::vector<Ipv4Address> &sinks);
+  bool IsSink(Ipv4Address address) const;
+  /// Orientation of a newly discovered link: toward the sinks, otherwise toward the higher address
+  bool PointsToward(Ipv4Address neighbor) const;
 
-  Ipv4Address m_sink; // Destination
+  Ipv4Address m_sink; // Anycast destination, the first sink
+  std::vector<Ipv4Address> m_sinks; // Sinks, roots of the DAG
   Ipv4Address m_nodeAddress; // Node Address
   Ipv4Address m_broadcastAddress; // Broadcast Address
   bool initialized = false;
   uint m_index; // Index of node based on creation
   float hopSum; // Sum of hop count (for average calculation)
   int nPacketReceived; // Number of received packets (for hop count average calculation)
+  uint32_t m_sequence; // Sequence number of the last control message sent
+  uint32_t m_controlReceived; // Control messages processed
+  uint32_t m_duplicatesSuppressed; // Control messages discarded as duplicates
   Ptr<Ipv4> m_ipv4;
-  std::set<Ipv4Address> m_neighbors; // Direct neighbors
-  std::map<Ipv4Address, int> m_linkStatus; // Link orientation (1 = active/exiting)
-  std::map<Ipv4Address, uint> m_cycleDetection; // Keep trace of cycle for each neighbor
-  std::map<Ipv4Address, EventId> m_disableLinkToEvent; // Event that fires link disable when neighbor is not reachable
+  Ptr<UniformRandomVariable> m_uniformRandomVariable; // Jitter of the messages sent
+
+  /// Everything known about one neighbor, 24 bytes
+  struct NeighborEntry
+  {
+    uint32_t address; // Neighbor address
+    int8_t state; // Link orientation (-1 = unknown, 0 = incoming, 1 = outgoing)
+    uint8_t congestion; // Last queue occupancy advertised
+    uint8_t energy; // Last remaining energy advertised
+    bool linked; // False while the node was only heard, before any link operation
+    uint32_t ackDeadline; // Timer tick at which the link is disabled without ACK response, 0 if none
+    uint32_t suspectedUntil; // Closed a loop, avoided until this timer tick
+    uint32_t confirmedTick; // Timer tick of the last ACK response, 0 if none
+    uint8_t freshnessShift; // Halvings of the freshness window by ACK timeouts, at most 8
+  };
+  NeighborEntry *FindNeighbor (Ipv4Address neighbor);
+  const NeighborEntry *FindNeighbor (Ipv4Address neighbor) const;
+  NeighborEntry &GetNeighbor (Ipv4Address neighbor);
+  /// Whether the neighbor answered an ACK probe within its current freshness window
+  bool IsFresh (const NeighborEntry &entry) const;
+  std::vector<NeighborEntry> m_neighbors; // Neighbor table, sorted by address
+  bool m_congestionAware; // Prefer the least congested outgoing link
+
+  /// Last position and velocity advertised by a neighbor, 24 bytes
+  struct NeighborMotion
+  {
+    uint32_t address; // Neighbor address
+    uint32_t heardTick; // Timer tick of the advertisement
+    float position[2]; // Position when heard (m)
+    float velocity[2]; // Velocity (m/s)
+  };
+  std::vector<NeighborMotion> m_neighborMotion; // Sorted by address, filled only if m_mobilityAware
+  bool m_mobilityAware; // Advertise mobility and avoid links predicted to break
+  double m_linkRange; // Distance at which a link breaks (m)
+  Time m_linkLifetimeThreshold; // Links predicted to last less are used only as a last resort
+  Ptr<MobilityModel> m_mobility; // Own mobility model, null if the node has none
+  uint32_t m_reversals; // Full link reversals performed
+  double m_lowEnergyThreshold; // Neighbors below this energy fraction are avoided, zero disables
+  Callback<double> m_energyLevel; // Remaining energy fraction of this node
+  Time m_loopSuspicionTimeout; // How long a neighbor stays suspected after a loop
+  Time m_loopDetectionWindow; // How long a forwarded packet is remembered
+
+  /// Packet recently forwarded by this node
+  struct ForwardedEntry
+  {
+    uint32_t source; // Packet source address
+    uint16_t identification; // IPv4 identification of the packet
+    Ipv4Address nextHop; // Neighbor the packet was sent to
+    Time expiry; // Entry is ignored after this time
+  };
+  static const uint32_t FORWARDED_FILTER_SIZE = 256;
+  std::array<ForwardedEntry, FORWARDED_FILTER_SIZE> m_forwardedFilter; // Direct-mapped visited-path filter
+
+  /// Control message recently processed by this node
+  struct DuplicateEntry
+  {
+    uint32_t origin; // Sender address
+    uint32_t sequence; // Sender sequence number
+    Time expiry; // Entry is ignored after this time
+  };
+  static const uint32_t DUPLICATE_CACHE_SIZE = 512;
+  std::array<DuplicateEntry, DUPLICATE_CACHE_SIZE> m_duplicateCache; // Direct-mapped (origin, sequence) cache
+  Time m_duplicateCacheLifetime; // How long a processed message is remembered
+  bool m_aggregatedDiscovery; // Periodic discovery broadcasts instead of hello/hello response
+  Time m_discoveryInterval; // Time between two discovery broadcasts
+  uint32_t m_discoveryRounds; // Number of discovery broadcasts sent on bootstrap
+  EventId m_discoveryEvent; // Next discovery broadcast
+
+  /// Downstream route toward a data source, learned from the packets it sends to the sink
+  struct ReverseRoute
+  {
+    uint32_t source; // Source address
+    uint32_t nextHop; // Neighbor the source's packets came from
+    Time expiry; // Route is removed after this time, refreshed by every packet it carries
+  };
+  std::vector<ReverseRoute> m_reverseRoutes; // Reverse routes, sorted by source
+  Time m_reverseRouteLifetime; // How long a reverse route lives without traffic
+
+  /// Data packet held for aggregation
+  struct AggregatedPacket
+  {
+    Ptr<Packet> payload; // Packet without IP header
+    Ipv4Header header; // IP header, TTL already decremented
+  };
+  std::vector<AggregatedPacket> m_aggregateQueue; // Packets bound for the sink waiting for a frame
+  uint32_t m_aggregateBytes; // Size of the queued datagrams, IP headers included
+  uint32_t m_aggregateFrames; // Aggregate frames sent
+  uint32_t m_aggregatedPackets; // Packets carried by the aggregate frames sent
+  EventId m_aggregateEvent; // End of the aggregation window
+  Time m_aggregationWindow; // How long a packet may wait for others, zero disables aggregation
+  uint32_t m_aggregationMaxSize; // Maximum size of the datagrams in one frame
+
+  /*
+   * Link timeouts live in a hashed timing wheel: slot t % size lists the neighbors whose
+   * ACK deadline is tick t. Cancelling clears the deadline in the neighbor entry and leaves
+   * the stale slot item to be skipped, so arming and cancelling are O(1) and a single
+   * simulator event, pending only while timeouts are armed, advances the wheel.
+   */
+  Time m_ackTimeout; // Time an ACK response may take before the link is disabled
+  Time m_freshnessWindow; // No ACK probe within this time of an ACK response, zero disables
+  uint32_t m_ackProbesSuppressed; // Probes skipped on fresh links
+  Time m_timerResolution; // Duration of a timer tick
+  std::vector<std::vector<uint32_t>> m_timerWheel; // Neighbor addresses by deadline tick
+  uint32_t m_timerTick; // Tick processed by the next wheel advance
+  uint32_t m_pendingTimeouts; // Armed link timeouts
+  EventId m_timerEvent; // Next wheel advance
+
+  /*
+   * Partition detection follows TORA: a failed link is removed, the node that loses its
+   * last outgoing link to a failure starts a new reference level, and the others
+   * propagate, reflect or detect a partition from the levels of their neighbors.
+   * Reversals only turn the links toward neighbors below the new level.
+   */
+  bool m_partitionDetection; // Detect partitions instead of reversing forever
+  Time m_rejoinInterval; // Time before the first rejoin probe, doubled after every probe
+  uint32_t m_rejoinAttempts; // Rejoin probes sent before a partitioned node gives up
+  uint32_t m_rejoinProbes; // Rejoin probes sent in the current partition
+  ReferenceLevel m_level; // Level of the last reversal of this node
+  /// Level last advertised by a neighbor
+  struct NeighborLevel
+  {
+    uint32_t address; // Neighbor address
+    ReferenceLevel level; // Level of its last reversal
+  };
+  std::vector<NeighborLevel> m_neighborLevels; // Sorted by address, filled by reversal messages
+  bool m_partitioned; // Cut off from the sink, reversals suspended
+  EventId m_rejoinEvent; // Next rejoin probe
+  uint32_t m_partitions; // Partitions entered
+  uint32_t m_rejoins; // Partitions left
+  /// Route shared by the packets sent through one neighbor and interface
+  struct CachedRoute
+  {
+    uint32_t gateway; // Next hop address
+    uint32_t interface; // Output interface
+    Ptr<Ipv4Route> route;
+  };
+  std::vector<CachedRoute> m_routeCache; // Sorted by gateway and interface
+  Ptr<Packet> m_controlTemplate; // Empty packet carrying the TTL tag of control messages
+  bool m_detached; // Interface down or address removed, routing state cleared
+
+  TracedCallback<Ipv4Address, int, int> m_linkStateTrace; // Link orientation changes
+  TracedCallback<uint32_t> m_reversalTrace; // Full link reversals
+  TracedCallback<Ptr<const Packet>, const Ipv4Header &, Ipv4Address> m_forwardTrace; // Forwarded packets
+  TracedCallback<Ptr<const Packet>, const Ipv4Header &, LraDropReason> m_dropTrace; // Dropped packets
+  TracedCallback<Ipv4Address> m_loopTrace; // Detected loops
+  TracedCallback<Ipv4Address> m_partitionTrace; // Partitions entered
+  TracedCallback<Ipv4Address> m_rejoinTrace; // Partitions left
 };
 } // namespace ns3
 
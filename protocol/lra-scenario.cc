@@ -0,0 +1,305 @@
+#include "lra-scenario.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace ns3
+{
+
+namespace
+{
+
+/// Split a line into whitespace separated words, stopping at a comment
+void
+Tokenize(const std::string& line, std::vector<std::string>& words)
+{
+    words.clear();
+    size_t i = 0;
+    while (i < line.size() && line[i] != '#')
+    {
+        if (line[i] == ' ' || line[i] == '\t' || line[i] == '\r')
+        {
+            ++i;
+            continue;
+        }
+        size_t begin = i;
+        while (i < line.size() && line[i] != ' ' && line[i] != '\t' && line[i] != '\r' &&
+               line[i] != '#')
+        {
+            ++i;
+        }
+        words.emplace_back(line, begin, i - begin);
+    }
+}
+
+bool
+ParseDouble(const std::string& word, double& value)
+{
+    char* end;
+    value = std::strtod(word.c_str(), &end);
+    return !word.empty() && *end == '\0';
+}
+
+bool
+ParseIndex(const std::string& word, uint32_t& value)
+{
+    char* end;
+    unsigned long parsed = std::strtoul(word.c_str(), &end, 10);
+    value = static_cast<uint32_t>(parsed);
+    return !word.empty() && *end == '\0' && word[0] != '-';
+}
+
+/// Parse words[first..] as numbers, checking their count
+bool
+ParseNumbers(const std::vector<std::string>& words,
+             size_t first,
+             size_t minCount,
+             size_t maxCount,
+             std::vector<double>& values)
+{
+    size_t count = words.size() - first;
+    if (count < minCount || count > maxCount)
+    {
+        return false;
+    }
+    values.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (!ParseDouble(words[first + i], values[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool
+LraScenario::Load(const std::string& filename, std::string& error)
+{
+    // Large node lists are read through a bigger buffer than the default one
+    std::vector<char> buffer(1 << 20);
+    std::ifstream file;
+    file.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+    file.open(filename);
+    if (!file)
+    {
+        error = filename + ": cannot open the file";
+        return false;
+    }
+
+    std::string line;
+    std::vector<std::string> words;
+    std::vector<double> values;
+    uint32_t lineNumber = 0;
+    auto fail = [&](const std::string& reason) {
+        std::ostringstream os;
+        os << filename << ":" << lineNumber << ": " << reason;
+        error = os.str();
+        return false;
+    };
+
+    while (std::getline(file, line))
+    {
+        ++lineNumber;
+        Tokenize(line, words);
+        if (words.empty())
+        {
+            continue;
+        }
+        const std::string& keyword = words[0];
+
+        if (keyword == "node")
+        {
+            // The hot path of large scenarios: numbers fit the small string buffer of the
+            // reused words, so a node line allocates nothing
+            if (!ParseNumbers(words, 1, 2, 3, values))
+            {
+                return fail("expected 'node <x> <y> [<z>]'");
+            }
+            positions.push_back(
+                LraScenarioPosition{values[0], values[1], values.size() > 2 ? values[2] : 0});
+        }
+        else if (keyword == "nodes")
+        {
+            if (words.size() != 2 || !ParseIndex(words[1], nodeCount) || nodeCount == 0)
+            {
+                return fail("expected 'nodes <count>'");
+            }
+            positions.reserve(nodeCount);
+        }
+        else if (keyword == "area")
+        {
+            if (!ParseNumbers(words, 1, 2, 2, values) || values[0] <= 0 || values[1] <= 0)
+            {
+                return fail("expected 'area <width> <height>'");
+            }
+            width = values[0];
+            height = values[1];
+        }
+        else if (keyword == "placement")
+        {
+            if (words.size() < 2)
+            {
+                return fail("expected 'placement <random|grid|cluster|corridor> ...'");
+            }
+            placement = words[1];
+            bool valid = (placement == "random" && ParseNumbers(words, 2, 0, 0, values)) ||
+                         (placement == "grid" && ParseNumbers(words, 2, 1, 1, values)) ||
+                         (placement == "cluster" && ParseNumbers(words, 2, 2, 2, values)) ||
+                         (placement == "corridor" && ParseNumbers(words, 2, 1, 1, values));
+            if (!valid)
+            {
+                return fail("expected 'placement random', 'placement grid <columns>', "
+                            "'placement cluster <count> <radius>' or 'placement corridor <width>'");
+            }
+            placementParameters = values;
+        }
+        else if (keyword == "mobility")
+        {
+            if (words.size() < 2)
+            {
+                return fail("expected 'mobility <static|walk|pareto> ...'");
+            }
+            mobility = words[1];
+            bool valid = (mobility == "static" && ParseNumbers(words, 2, 0, 0, values)) ||
+                         (mobility == "walk" && ParseNumbers(words, 2, 2, 2, values)) ||
+                         (mobility == "pareto" && ParseNumbers(words, 2, 3, 3, values));
+            if (!valid)
+            {
+                return fail("expected 'mobility static', 'mobility walk <min> <max>' or "
+                            "'mobility pareto <scale> <shape> <bound>'");
+            }
+            mobilityParameters = values;
+        }
+        else if (keyword == "channel")
+        {
+            if (words.size() < 2 || words.size() > 3 ||
+                (words.size() == 3 && (!ParseDouble(words[2], range) || range <= 0)))
+            {
+                return fail("expected 'channel <wifi|gridwifi|unitdisk> [<range>]'");
+            }
+            channel = words[1];
+        }
+        else if (keyword == "sink" || keyword == "source")
+        {
+            if (keyword == "source" && words.size() == 2 && words[1] == "all")
+            {
+                allSources = true;
+                continue;
+            }
+            std::vector<uint32_t>& list = (keyword == "sink") ? sinks : sources;
+            if (words.size() < 2)
+            {
+                return fail("expected '" + keyword + " <index>...'");
+            }
+            for (size_t i = 1; i < words.size(); ++i)
+            {
+                uint32_t index;
+                if (!ParseIndex(words[i], index))
+                {
+                    return fail("invalid node index '" + words[i] + "'");
+                }
+                list.push_back(index);
+            }
+        }
+        else if (keyword == "traffic")
+        {
+            if (words.size() < 2 || words.size() > 4)
+            {
+                return fail("expected 'traffic <model> [<rate> [<packet size>]]'");
+            }
+            traffic = words[1];
+            if (words.size() > 2)
+            {
+                rate = words[2];
+            }
+            if (words.size() > 3 && (!ParseIndex(words[3], packetSize) || packetSize == 0))
+            {
+                return fail("invalid packet size '" + words[3] + "'");
+            }
+        }
+        else if (keyword == "start" || keyword == "duration")
+        {
+            if (!ParseNumbers(words, 1, 1, 1, values) || values[0] < 0)
+            {
+                return fail("expected '" + keyword + " <s>'");
+            }
+            (keyword == "start" ? start : duration) = values[0];
+        }
+        else if (keyword == "metrics")
+        {
+            metrics.assign(words.begin() + 1, words.end());
+        }
+        else if (keyword == "crash")
+        {
+            LraScenarioFailure failure{0, 0, {}, 0, 0, 0, 0};
+            if (words.size() < 4 || !ParseDouble(words[1], failure.time) ||
+                !ParseDouble(words[2], failure.downtime) || failure.time < 0 ||
+                failure.downtime < 0)
+            {
+                return fail("expected 'crash <time> <downtime> <index>...'");
+            }
+            for (size_t i = 3; i < words.size(); ++i)
+            {
+                uint32_t index;
+                if (!ParseIndex(words[i], index))
+                {
+                    return fail("invalid node index '" + words[i] + "'");
+                }
+                failure.nodes.push_back(index);
+            }
+            failures.push_back(failure);
+        }
+        else if (keyword == "region")
+        {
+            if (!ParseNumbers(words, 1, 6, 6, values) || values[0] < 0 || values[1] < 0 ||
+                values[2] > values[4] || values[3] > values[5])
+            {
+                return fail("expected 'region <time> <downtime> <x0> <y0> <x1> <y1>'");
+            }
+            failures.push_back(LraScenarioFailure{values[0],
+                                                  values[1],
+                                                  {},
+                                                  values[2],
+                                                  values[3],
+                                                  values[4],
+                                                  values[5]});
+        }
+        else
+        {
+            return fail("unknown keyword '" + keyword + "'");
+        }
+    }
+
+    if (nodeCount == 0)
+    {
+        nodeCount = positions.size();
+    }
+    if (positions.size() > nodeCount)
+    {
+        error = filename + ": more node positions than nodes";
+        return false;
+    }
+    std::vector<uint32_t> failing;
+    for (const auto& failure : failures)
+    {
+        failing.insert(failing.end(), failure.nodes.begin(), failure.nodes.end());
+    }
+    for (const auto* list : {&sinks, &sources, &failing})
+    {
+        for (uint32_t index : *list)
+        {
+            if (nodeCount > 0 && index >= nodeCount)
+            {
+                error = filename + ": node index " + std::to_string(index) + " out of range";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace ns3
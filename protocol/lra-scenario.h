@@ -0,0 +1,102 @@
+#ifndef LRA_SCENARIO_H
+#define LRA_SCENARIO_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Declarative benchmark scenario. Kept free of ns-3 includes like the other
+ * file formats of the benchmark; the benchmark turns it into nodes, devices
+ * and applications.
+ *
+ * A scenario file is read line by line in a single pass, so node lists of any
+ * length load without an intermediate document. Empty lines and text after
+ * '#' are ignored. Every other line is a keyword followed by its arguments:
+ *
+ *   nodes <count>                      number of nodes
+ *   area <width> <height>              deployment area (m)
+ *   placement random                   uniform in the area
+ *   placement grid <columns>           regular grid filling the area
+ *   placement cluster <count> <radius> uniform discs around random centers
+ *   placement corridor <width>         uniform in a horizontal band across the area
+ *   node <x> <y> [<z>]                 explicit position of the next node (m),
+ *                                      takes precedence over the placement
+ *   mobility static                    nodes never move
+ *   mobility walk <min> <max>          random walk, uniform speed (m/s)
+ *   mobility pareto <scale> <shape> <bound>
+ *                                      random walk, Pareto speed (m/s)
+ *   channel <wifi|gridwifi|unitdisk> [<range>]
+ *   sink <index>...                    sink nodes, one anycast destination addressed
+ *                                      by the first one listed
+ *   source <index>... | source all     nodes sending traffic (default: all but the sinks)
+ *   traffic <model> [<rate> [<packet size>]]
+ *                                      rate as a data rate, e.g. 16kbps
+ *   start <s>                          bootstrap time before traffic starts
+ *   duration <s>                       traffic duration
+ *   metrics <name>...                  report sections to print
+ *   crash <time> <downtime> <index>... the nodes' interfaces go down at <time> (s) and
+ *                                      come back <downtime> s later, never if 0
+ *   region <time> <downtime> <x0> <y0> <x1> <y1>
+ *                                      cuts the links between the nodes inside the
+ *                                      rectangle and the others at <time> and restores
+ *                                      them <downtime> s later, never if 0
+ *
+ * Mobility starts at the end of the bootstrap.
+ */
+
+namespace ns3 {
+
+/// Explicit position of one node, m
+struct LraScenarioPosition
+{
+  double x;
+  double y;
+  double z;
+};
+
+/// Failure injected by the benchmark
+struct LraScenarioFailure
+{
+  double time; ///< Injection time, s
+  double downtime; ///< Time before the nodes come back, s, 0 for never
+  std::vector<uint32_t> nodes; ///< Failing nodes, empty for a region
+  double x0, y0, x1, y1; ///< Region cut from the rest of the network, m
+};
+
+/// Content of a scenario file; unset fields keep the benchmark defaults
+struct LraScenario
+{
+  uint32_t nodeCount = 0; ///< 0 if not given
+  double width = 0; ///< Area width, 0 if not given
+  double height = 0; ///< Area height, 0 if not given
+  std::string placement; ///< random, grid, cluster or corridor, empty if not given
+  std::vector<double> placementParameters;
+  std::vector<LraScenarioPosition> positions; ///< Explicit positions of the first nodes
+  std::string mobility; ///< static, walk or pareto, empty if not given
+  std::vector<double> mobilityParameters;
+  std::string channel; ///< Empty if not given
+  double range = 0; ///< Unit disk range, 0 if not given
+  std::vector<uint32_t> sinks; ///< Empty if not given
+  std::vector<uint32_t> sources; ///< Empty if not given
+  bool allSources = false; ///< "source all" was given
+  std::string traffic; ///< Empty if not given
+  std::string rate; ///< Empty if not given
+  uint32_t packetSize = 0; ///< 0 if not given
+  double start = -1; ///< Negative if not given
+  double duration = -1; ///< Negative if not given
+  std::vector<std::string> metrics; ///< Empty if not given
+  std::vector<LraScenarioFailure> failures; ///< In file order
+
+  /**
+   * Read a scenario file.
+   * \param filename the file to read
+   * \param error set to "<file>:<line>: <reason>" on failure
+   * \return false if the file is missing or malformed
+   */
+  bool Load (const std::string &filename, std::string &error);
+};
+
+} // namespace ns3
+
+#endif /* LRA_SCENARIO_H */
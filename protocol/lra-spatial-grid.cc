@@ -0,0 +1,178 @@
+#include "lra-spatial-grid.h"
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("LraSpatialGrid");
+
+LraSpatialGrid::LraSpatialGrid()
+    : m_cellSize(std::numeric_limits<double>::infinity()),
+      m_slack(0),
+      m_maxSpeed(0)
+{
+}
+
+LraSpatialGrid::~LraSpatialGrid()
+{
+}
+
+void
+LraSpatialGrid::SetCellSize(double cellSize, double slack)
+{
+    NS_LOG_FUNCTION(this << cellSize << slack);
+    NS_ASSERT_MSG(m_items.empty(), "Grid geometry must be set before adding items");
+    NS_ASSERT_MSG(cellSize > 0 && slack > 0, "Cell size and slack must be positive");
+    m_cellSize = cellSize;
+    m_slack = slack;
+}
+
+bool
+LraSpatialGrid::IsBounded() const
+{
+    return std::isfinite(m_cellSize);
+}
+
+void
+LraSpatialGrid::Add(uint32_t id, Ptr<MobilityModel> mobility)
+{
+    NS_LOG_FUNCTION(this << id << mobility);
+
+    if (id >= m_items.size())
+    {
+        m_items.resize(id + 1, Item{nullptr, 0, 0, false});
+    }
+    NS_ASSERT_MSG(!m_items[id].present, "Item " << id << " already in the grid");
+    m_items[id].mobility = mobility;
+
+    auto& ids = m_byMobility[PeekPointer(mobility)];
+    if (ids.empty())
+    {
+        mobility->TraceConnectWithoutContext("CourseChange",
+                                             MakeCallback(&LraSpatialGrid::CourseChanged, this));
+    }
+    ids.push_back(id);
+
+    TrackSpeed(mobility);
+    Place(id);
+}
+
+void
+LraSpatialGrid::Remove(uint32_t id)
+{
+    NS_LOG_FUNCTION(this << id);
+
+    if (id >= m_items.size() || !m_items[id].present)
+        return;
+
+    Unplace(id);
+    Ptr<MobilityModel> mobility = m_items[id].mobility;
+    auto entry = m_byMobility.find(PeekPointer(mobility));
+    auto& ids = entry->second;
+    ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+    if (ids.empty())
+    {
+        // Add connects again if the model comes back
+        mobility->TraceDisconnectWithoutContext("CourseChange",
+                                                MakeCallback(&LraSpatialGrid::CourseChanged, this));
+        m_byMobility.erase(entry);
+    }
+    m_items[id].mobility = nullptr;
+}
+
+void
+LraSpatialGrid::CourseChanged(Ptr<const MobilityModel> mobility)
+{
+    auto entry = m_byMobility.find(PeekPointer(mobility));
+    if (entry == m_byMobility.end())
+        return;
+
+    TrackSpeed(mobility);
+    for (uint32_t id : entry->second)
+    {
+        Unplace(id);
+        Place(id);
+    }
+}
+
+void
+LraSpatialGrid::TrackSpeed(Ptr<const MobilityModel> mobility)
+{
+    Vector v = mobility->GetVelocity();
+    double speed = std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+    m_maxSpeed = std::max(m_maxSpeed, speed);
+}
+
+void
+LraSpatialGrid::MaybeRefresh()
+{
+    if (m_maxSpeed == 0 || !IsBounded())
+        return;
+
+    Time now = Simulator::Now();
+    if ((now - m_lastRefresh).GetSeconds() * m_maxSpeed <= m_slack)
+        return;
+
+    NS_LOG_LOGIC("Re-bucketing " << m_items.size() << " items");
+    for (uint32_t id = 0; id < m_items.size(); ++id)
+    {
+        if (!m_items[id].present)
+            continue;
+        Unplace(id);
+        Place(id);
+    }
+    m_lastRefresh = now;
+}
+
+void
+LraSpatialGrid::Place(uint32_t id)
+{
+    Item& item = m_items[id];
+    Vector p = item.mobility->GetPosition();
+    item.cell = IsBounded() ? CellKey(CellCoordinate(p.x), CellCoordinate(p.y)) : 0;
+    auto& cell = m_cells[item.cell];
+    item.slot = cell.size();
+    item.present = true;
+    cell.push_back(id);
+}
+
+void
+LraSpatialGrid::Unplace(uint32_t id)
+{
+    Item& item = m_items[id];
+    if (!item.present)
+        return;
+
+    // Swap-remove keeps removal O(1), the moved id gets its slot fixed up
+    auto& cell = m_cells[item.cell];
+    uint32_t last = cell.back();
+    cell[item.slot] = last;
+    m_items[last].slot = item.slot;
+    cell.pop_back();
+    if (cell.empty())
+    {
+        m_cells.erase(item.cell);
+    }
+    item.present = false;
+}
+
+int64_t
+LraSpatialGrid::CellCoordinate(double v) const
+{
+    if (!IsBounded())
+        return 0;
+    return static_cast<int64_t>(std::floor(v / m_cellSize));
+}
+
+int64_t
+LraSpatialGrid::CellKey(int64_t cx, int64_t cy) const
+{
+    return (cx << 32) ^ (cy & 0xffffffff);
+}
+
+} // namespace ns3
@@ -0,0 +1,110 @@
+#ifndef LRA_SPATIAL_GRID_H
+#define LRA_SPATIAL_GRID_H
+
+#include "ns3/mobility-model.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+#include "ns3/vector.h"
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Uniform 2D grid of mobile items, kept up to date from mobility traces.
+ *
+ * Items are bucketed by position into square cells. A bucket is updated as soon
+ * as the item's mobility model fires CourseChange; between course changes an
+ * item moves linearly, so the whole grid is re-bucketed every time the fastest
+ * item could have drifted more than Slack meters. Queries are widened by Slack,
+ * hence every item really within the query radius is always returned, possibly
+ * together with a few farther ones that the caller has to filter out.
+ */
+class LraSpatialGrid
+{
+public:
+  /** Constructor */
+  LraSpatialGrid ();
+  /** Destructor */
+  ~LraSpatialGrid ();
+
+  /**
+   * Set the grid geometry, must be called before adding items.
+   * \param cellSize side of a cell, usually the radio range (m)
+   * \param slack maximum drift tolerated before a full re-bucketing (m)
+   */
+  void SetCellSize (double cellSize, double slack);
+  /**
+   * Start tracking an item.
+   * \param id caller-chosen identifier, reported back by ForEachCandidate
+   * \param mobility the mobility model of the item
+   */
+  void Add (uint32_t id, Ptr<MobilityModel> mobility);
+  /** Stop tracking an item */
+  void Remove (uint32_t id);
+  /** \return true if the grid has a finite cell size */
+  bool IsBounded () const;
+
+  /**
+   * Call f(id) for every item that may lie within radius meters from center.
+   */
+  template <typename F>
+  void ForEachCandidate (const Vector &center, double radius, F f);
+
+private:
+  /// Position of an item inside the grid
+  struct Item
+  {
+    Ptr<MobilityModel> mobility;
+    int64_t cell;
+    uint32_t slot; // Index inside the cell vector
+    bool present;
+  };
+
+  void CourseChanged (Ptr<const MobilityModel> mobility);
+  void Place (uint32_t id);
+  void Unplace (uint32_t id);
+  void TrackSpeed (Ptr<const MobilityModel> mobility);
+  void MaybeRefresh ();
+  int64_t CellKey (int64_t cx, int64_t cy) const;
+  int64_t CellCoordinate (double v) const;
+
+  double m_cellSize; // Cell side (m)
+  double m_slack; // Maximum tolerated drift (m)
+  double m_maxSpeed; // Highest speed seen so far (m/s)
+  Time m_lastRefresh; // Last full re-bucketing
+  std::vector<Item> m_items; // Indexed by id
+  std::unordered_map<int64_t, std::vector<uint32_t>> m_cells; // Cell -> ids
+  std::unordered_map<const MobilityModel *, std::vector<uint32_t>> m_byMobility; // Course change lookup
+};
+
+template <typename F>
+void
+LraSpatialGrid::ForEachCandidate (const Vector &center, double radius, F f)
+{
+  MaybeRefresh ();
+  double reach = radius + m_slack;
+  int64_t minX = CellCoordinate (center.x - reach);
+  int64_t maxX = CellCoordinate (center.x + reach);
+  int64_t minY = CellCoordinate (center.y - reach);
+  int64_t maxY = CellCoordinate (center.y + reach);
+  for (int64_t cx = minX; cx <= maxX; ++cx)
+    {
+      for (int64_t cy = minY; cy <= maxY; ++cy)
+        {
+          auto cell = m_cells.find (CellKey (cx, cy));
+          if (cell == m_cells.end ())
+            continue;
+          for (uint32_t id : cell->second)
+            {
+              f (id);
+            }
+        }
+    }
+}
+
+} // namespace ns3
+
+#endif /* LRA_SPATIAL_GRID_H */
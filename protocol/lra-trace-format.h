@@ -0,0 +1,60 @@
+#ifndef LRA_TRACE_FORMAT_H
+#define LRA_TRACE_FORMAT_H
+
+#include <cstdint>
+
+/*
+ * Binary event trace layout, shared by the benchmark and the offline tools.
+ * Kept free of ns-3 includes so that tools/ can be built with a plain compiler.
+ *
+ * A trace file is a LraTraceFileHeader followed by fixed-size LraTraceRecord
+ * entries, all in host byte order.
+ */
+
+namespace ns3 {
+
+/// Magic bytes at the start of every binary trace
+static const char LRA_TRACE_MAGIC[8] = {'L', 'R', 'A', 'T', 'R', 'A', 'C', 'E'};
+static const uint32_t LRA_TRACE_VERSION = 1;
+
+/// Kind of event stored in a record
+enum LraTraceEventType : uint8_t
+{
+  LRA_TRACE_COURSE_CHANGE = 0, ///< x, y, vx, vy in f
+  LRA_TRACE_LINK_STATE = 1, ///< u[0] neighbor, i[1] old state, i[2] new state
+  LRA_TRACE_REVERSAL = 2, ///< u[0] number of links reversed
+  LRA_TRACE_FORWARD = 3, ///< u[0] packet uid, u[1] next hop, u[2] source, u[3] destination
+  LRA_TRACE_DROP = 4, ///< u[0] packet uid, u[1] reason, u[2] source, u[3] destination
+  LRA_TRACE_LOOP = 5, ///< u[0] suspected neighbor
+  LRA_TRACE_PARTITION = 6, ///< u[0] node that detected the partition
+  LRA_TRACE_REJOIN = 7, ///< u[0] connected neighbor that answered
+  LRA_TRACE_EVENT_TYPES
+};
+
+struct LraTraceFileHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t recordSize;
+};
+
+/// One event, 32 bytes
+struct LraTraceRecord
+{
+  int64_t timeNs; ///< Simulation time of the event
+  uint32_t node; ///< Node id of the reporting node
+  uint8_t type; ///< LraTraceEventType
+  uint8_t reserved[3];
+  union
+  {
+    float f[4];
+    uint32_t u[4];
+    int32_t i[4];
+  };
+};
+
+static_assert (sizeof (LraTraceRecord) == 32, "LraTraceRecord must stay 32 bytes");
+
+} // namespace ns3
+
+#endif /* LRA_TRACE_FORMAT_H */
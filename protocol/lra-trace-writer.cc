@@ -0,0 +1,87 @@
+#include "lra-trace-writer.h"
+
+#include <cstring>
+
+namespace ns3
+{
+
+LraTraceWriter::LraTraceWriter()
+    : m_records(0)
+{
+}
+
+LraTraceWriter::~LraTraceWriter()
+{
+    Close();
+}
+
+bool
+LraTraceWriter::Open(const std::string& filename)
+{
+    Close();
+    m_file.open(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!m_file)
+    {
+        return false;
+    }
+
+    LraTraceFileHeader header;
+    std::memcpy(header.magic, LRA_TRACE_MAGIC, sizeof(header.magic));
+    header.version = LRA_TRACE_VERSION;
+    header.recordSize = sizeof(LraTraceRecord);
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    m_buffer.reserve(BUFFER_RECORDS);
+    m_records = 0;
+    return true;
+}
+
+bool
+LraTraceWriter::IsOpen() const
+{
+    return m_file.is_open();
+}
+
+void
+LraTraceWriter::Write(const LraTraceRecord& record)
+{
+    if (!m_file.is_open())
+    {
+        return;
+    }
+    m_buffer.push_back(record);
+    m_records++;
+    if (m_buffer.size() >= BUFFER_RECORDS)
+    {
+        Flush();
+    }
+}
+
+void
+LraTraceWriter::Flush()
+{
+    if (!m_buffer.empty())
+    {
+        m_file.write(reinterpret_cast<const char*>(m_buffer.data()),
+                     m_buffer.size() * sizeof(LraTraceRecord));
+        m_buffer.clear();
+    }
+}
+
+void
+LraTraceWriter::Close()
+{
+    if (m_file.is_open())
+    {
+        Flush();
+        m_file.close();
+    }
+}
+
+uint64_t
+LraTraceWriter::GetRecordCount() const
+{
+    return m_records;
+}
+
+} // namespace ns3
@@ -0,0 +1,53 @@
+#ifndef LRA_TRACE_WRITER_H
+#define LRA_TRACE_WRITER_H
+
+#include "lra-trace-format.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Buffered writer of the binary event trace described in lra-trace-format.h.
+ *
+ * Records are accumulated in memory and written in large blocks, so that
+ * tracing a long run costs one memcpy per event instead of a formatted write.
+ */
+class LraTraceWriter
+{
+public:
+  /** Constructor */
+  LraTraceWriter ();
+  /** Destructor, flushes pending records */
+  ~LraTraceWriter ();
+
+  /**
+   * Create the trace file and write its header.
+   * \param filename the file to create
+   * \return true if the file could be opened
+   */
+  bool Open (const std::string &filename);
+  /** \return true if a trace file is open */
+  bool IsOpen () const;
+  /** Append a record, buffered */
+  void Write (const LraTraceRecord &record);
+  /** Write buffered records to the file */
+  void Flush ();
+  /** Flush and close the file */
+  void Close ();
+  /** \return the number of records written so far */
+  uint64_t GetRecordCount () const;
+
+private:
+  static const size_t BUFFER_RECORDS = 4096;
+
+  std::ofstream m_file; // Trace file
+  std::vector<LraTraceRecord> m_buffer; // Records not yet written
+  uint64_t m_records; // Records accepted so far
+};
+
+} // namespace ns3
+
+#endif /* LRA_TRACE_WRITER_H */
@@ -0,0 +1,284 @@
+#include "lra-traffic-source.h"
+
+#include "ns3/data-rate.h"
+#include "ns3/enum.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/log.h"
+#include "ns3/packet.h"
+#include "ns3/pointer.h"
+#include "ns3/seq-ts-header.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+#include <fstream>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("LraTrafficSource");
+NS_OBJECT_ENSURE_REGISTERED(LraTrafficSource);
+
+TypeId
+LraTrafficSource::GetTypeId(void)
+{
+    static TypeId tid =
+        TypeId("ns3::LraTrafficSource")
+            .SetParent<Application>()
+            .AddConstructor<LraTrafficSource>()
+            .AddAttribute("Remote",
+                          "The address of the destination.",
+                          AddressValue(),
+                          MakeAddressAccessor(&LraTrafficSource::m_peer),
+                          MakeAddressChecker())
+            .AddAttribute("Model",
+                          "The traffic model.",
+                          EnumValue(LraTrafficSource::CBR),
+                          MakeEnumAccessor<Model>(&LraTrafficSource::m_model),
+                          MakeEnumChecker(LraTrafficSource::CBR,
+                                          "Cbr",
+                                          LraTrafficSource::POISSON,
+                                          "Poisson",
+                                          LraTrafficSource::ON_OFF,
+                                          "OnOff",
+                                          LraTrafficSource::TRACE,
+                                          "Trace"))
+            .AddAttribute("PacketSize",
+                          "Size of every packet, SeqTsHeader included (bytes).",
+                          UintegerValue(512),
+                          MakeUintegerAccessor(&LraTrafficSource::m_packetSize),
+                          MakeUintegerChecker<uint32_t>(12))
+            .AddAttribute("DataRate",
+                          "Offered rate at the start, peak rate for OnOff.",
+                          DataRateValue(DataRate("16kbps")),
+                          MakeDataRateAccessor(&LraTrafficSource::m_rate),
+                          MakeDataRateChecker())
+            .AddAttribute("RampStep",
+                          "Rate added every RampInterval.",
+                          DataRateValue(DataRate("0bps")),
+                          MakeDataRateAccessor(&LraTrafficSource::m_rampStep),
+                          MakeDataRateChecker())
+            .AddAttribute("RampInterval",
+                          "Time between two rate increases, zero disables the ramp.",
+                          TimeValue(Seconds(0)),
+                          MakeTimeAccessor(&LraTrafficSource::m_rampInterval),
+                          MakeTimeChecker())
+            .AddAttribute("OnTime",
+                          "Duration of the OnOff bursts (s).",
+                          StringValue("ns3::ConstantRandomVariable[Constant=1.0]"),
+                          MakePointerAccessor(&LraTrafficSource::m_onTime),
+                          MakePointerChecker<RandomVariableStream>())
+            .AddAttribute("OffTime",
+                          "Duration of the OnOff silences (s).",
+                          StringValue("ns3::ConstantRandomVariable[Constant=1.0]"),
+                          MakePointerAccessor(&LraTrafficSource::m_offTime),
+                          MakePointerChecker<RandomVariableStream>())
+            .AddAttribute("TraceFile",
+                          "Trace model input, one \"<time s> <size bytes>\" line per packet.",
+                          StringValue(""),
+                          MakeStringAccessor(&LraTrafficSource::m_traceFile),
+                          MakeStringChecker())
+            .AddTraceSource("Tx",
+                            "A packet was sent.",
+                            MakeTraceSourceAccessor(&LraTrafficSource::m_txTrace),
+                            "ns3::Packet::TracedCallback");
+    return tid;
+}
+
+LraTrafficSource::LraTrafficSource()
+    : m_on(false),
+      m_sequence(0),
+      m_totalBytes(0),
+      m_traceIndex(0)
+{
+    NS_LOG_FUNCTION(this);
+    m_gap = CreateObject<ExponentialRandomVariable>();
+}
+
+LraTrafficSource::~LraTrafficSource()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+LraTrafficSource::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    m_socket = nullptr;
+    Application::DoDispose();
+}
+
+int64_t
+LraTrafficSource::AssignStreams(int64_t stream)
+{
+    NS_LOG_FUNCTION(this << stream);
+    m_gap->SetStream(stream);
+    m_onTime->SetStream(stream + 1);
+    m_offTime->SetStream(stream + 2);
+    return 3;
+}
+
+DataRate
+LraTrafficSource::GetCurrentRate() const
+{
+    if (m_rampInterval.IsZero())
+    {
+        return m_rate;
+    }
+    uint64_t steps = (Simulator::Now() - m_startTime).GetNanoSeconds() /
+                     m_rampInterval.GetNanoSeconds();
+    return DataRate(m_rate.GetBitRate() + steps * m_rampStep.GetBitRate());
+}
+
+uint64_t
+LraTrafficSource::GetTotalBytes() const
+{
+    return m_totalBytes;
+}
+
+void
+LraTrafficSource::StartApplication()
+{
+    NS_LOG_FUNCTION(this);
+
+    if (!m_socket)
+    {
+        m_socket = Socket::CreateSocket(GetNode(), UdpSocketFactory::GetTypeId());
+        m_socket->Bind();
+        m_socket->Connect(m_peer);
+        m_socket->ShutdownRecv();
+    }
+    m_startTime = Simulator::Now();
+
+    switch (m_model)
+    {
+    case TRACE:
+        if (!LoadTrace())
+        {
+            NS_LOG_WARN("Cannot read traffic trace " << m_traceFile);
+            return;
+        }
+        m_traceIndex = 0;
+        ScheduleNext();
+        break;
+    case ON_OFF:
+        StartOnPeriod();
+        break;
+    default:
+        ScheduleNext();
+        break;
+    }
+}
+
+void
+LraTrafficSource::StopApplication()
+{
+    NS_LOG_FUNCTION(this);
+    m_sendEvent.Cancel();
+    m_periodEvent.Cancel();
+    if (m_socket)
+    {
+        m_socket->Close();
+    }
+}
+
+void
+LraTrafficSource::ScheduleNext()
+{
+    if (m_model == TRACE)
+    {
+        if (m_traceIndex >= m_trace.size())
+        {
+            return;
+        }
+        const auto& entry = m_trace[m_traceIndex++];
+        Time delay = std::max(Time(0), m_startTime + entry.first - Simulator::Now());
+        m_sendEvent =
+            Simulator::Schedule(delay, &LraTrafficSource::SendPacket, this, entry.second);
+        return;
+    }
+
+    DataRate rate = GetCurrentRate();
+    if (rate.GetBitRate() == 0)
+    {
+        return;
+    }
+    Time gap = rate.CalculateBytesTxTime(m_packetSize);
+    if (m_model == POISSON)
+    {
+        gap = Seconds(m_gap->GetValue(gap.GetSeconds(), 0));
+    }
+    m_sendEvent = Simulator::Schedule(gap, &LraTrafficSource::SendPacket, this, m_packetSize);
+}
+
+void
+LraTrafficSource::SendPacket(uint32_t size)
+{
+    NS_LOG_FUNCTION(this << size);
+
+    SeqTsHeader seqTs;
+    seqTs.SetSeq(m_sequence++);
+    uint32_t padding = size > seqTs.GetSerializedSize() ? size - seqTs.GetSerializedSize() : 0;
+    Ptr<Packet> packet = Create<Packet>(padding);
+    packet->AddHeader(seqTs);
+
+    if (m_socket->Send(packet) >= 0)
+    {
+        m_totalBytes += packet->GetSize();
+        m_txTrace(packet);
+    }
+    else
+    {
+        NS_LOG_INFO("Send failed at " << Simulator::Now().As(Time::S));
+    }
+
+    if (m_model != ON_OFF || m_on)
+    {
+        ScheduleNext();
+    }
+}
+
+void
+LraTrafficSource::StartOnPeriod()
+{
+    m_on = true;
+    m_periodEvent = Simulator::Schedule(Seconds(m_onTime->GetValue()),
+                                        &LraTrafficSource::StartOffPeriod,
+                                        this);
+    ScheduleNext();
+}
+
+void
+LraTrafficSource::StartOffPeriod()
+{
+    m_on = false;
+    m_sendEvent.Cancel();
+    m_periodEvent = Simulator::Schedule(Seconds(m_offTime->GetValue()),
+                                        &LraTrafficSource::StartOnPeriod,
+                                        this);
+}
+
+bool
+LraTrafficSource::LoadTrace()
+{
+    std::ifstream file(m_traceFile);
+    if (!file)
+    {
+        return false;
+    }
+    m_trace.clear();
+    double time;
+    uint32_t size;
+    while (file >> time >> size)
+    {
+        m_trace.emplace_back(Seconds(time), size);
+    }
+    std::stable_sort(m_trace.begin(), m_trace.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+    return true;
+}
+
+} // namespace ns3
@@ -0,0 +1,104 @@
+#ifndef LRA_TRAFFIC_SOURCE_H
+#define LRA_TRAFFIC_SOURCE_H
+
+#include "ns3/address.h"
+#include "ns3/application.h"
+#include "ns3/data-rate.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/socket.h"
+#include "ns3/traced-callback.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief UDP traffic generator for throughput and saturation runs.
+ *
+ * Every packet starts with a SeqTsHeader (sequence number and send time) and
+ * is padded to PacketSize bytes. Supported models:
+ *  - Cbr: one packet every PacketSize / DataRate
+ *  - Poisson: exponential gaps with the same mean
+ *  - OnOff: Cbr during OnTime periods, silent during OffTime periods
+ *  - Trace: "<time s> <size bytes>" lines of TraceFile, times relative to the start
+ *
+ * The offered load can grow during the run: every RampInterval the rate is
+ * increased by RampStep (Cbr, Poisson and OnOff only).
+ */
+class LraTrafficSource : public Application
+{
+public:
+  /// Traffic model
+  enum Model
+  {
+    CBR,
+    POISSON,
+    ON_OFF,
+    TRACE
+  };
+
+  static TypeId GetTypeId (void);
+  /** Constructor */
+  LraTrafficSource ();
+  /** Destructor */
+  virtual ~LraTrafficSource ();
+
+  /**
+   * Assign fixed random variable stream numbers.
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned
+   */
+  int64_t AssignStreams (int64_t stream);
+  /// \return the rate in use at the current time, including the ramp
+  DataRate GetCurrentRate () const;
+  /// \return the bytes sent so far
+  uint64_t GetTotalBytes () const;
+
+protected:
+  virtual void DoDispose ();
+
+private:
+  virtual void StartApplication ();
+  virtual void StopApplication ();
+
+  /// Schedule the next packet according to the model
+  void ScheduleNext ();
+  /// Send one packet and schedule the next one
+  void SendPacket (uint32_t size);
+  /// Begin an OnOff burst
+  void StartOnPeriod ();
+  /// End an OnOff burst
+  void StartOffPeriod ();
+  /// Read TraceFile into m_trace
+  bool LoadTrace ();
+
+  Address m_peer; // Destination of the traffic
+  uint32_t m_packetSize; // Packet size, SeqTsHeader included (bytes)
+  DataRate m_rate; // Initial rate (peak rate for OnOff)
+  DataRate m_rampStep; // Rate added at every ramp step
+  Time m_rampInterval; // Time between two ramp steps, zero disables the ramp
+  Model m_model; // Traffic model
+  Ptr<RandomVariableStream> m_onTime; // OnOff burst duration (s)
+  Ptr<RandomVariableStream> m_offTime; // OnOff silence duration (s)
+  Ptr<ExponentialRandomVariable> m_gap; // Poisson gaps
+  std::string m_traceFile; // Trace model input
+
+  Ptr<Socket> m_socket; // UDP socket connected to m_peer
+  EventId m_sendEvent; // Next packet
+  EventId m_periodEvent; // Next OnOff period change
+  bool m_on; // OnOff burst in progress
+  Time m_startTime; // Start of the traffic, ramp and trace origin
+  uint32_t m_sequence; // Next sequence number
+  uint64_t m_totalBytes; // Bytes sent
+  std::vector<std::pair<Time, uint32_t>> m_trace; // Trace model schedule
+  size_t m_traceIndex; // Next trace entry
+
+  TracedCallback<Ptr<const Packet>> m_txTrace; // Packets sent
+};
+
+} // namespace ns3
+
+#endif /* LRA_TRAFFIC_SOURCE_H */
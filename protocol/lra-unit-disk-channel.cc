@@ -0,0 +1,149 @@
+#include "lra-unit-disk-channel.h"
+
+#include "ns3/double.h"
+#include "ns3/log.h"
+#include "ns3/mobility-model.h"
+#include "ns3/node.h"
+#include "ns3/simulator.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("LraUnitDiskChannel");
+NS_OBJECT_ENSURE_REGISTERED(LraUnitDiskChannel);
+
+TypeId
+LraUnitDiskChannel::GetTypeId(void)
+{
+    static TypeId tid =
+        TypeId("ns3::LraUnitDiskChannel")
+            .SetParent<SimpleChannel>()
+            .AddConstructor<LraUnitDiskChannel>()
+            .AddAttribute("Range",
+                          "Maximum distance (m) at which a frame is received.",
+                          DoubleValue(100.0),
+                          MakeDoubleAccessor(&LraUnitDiskChannel::m_range),
+                          MakeDoubleChecker<double>(0.0))
+            .AddAttribute("LinkDelay",
+                          "Delay applied to every delivered frame.",
+                          TimeValue(MicroSeconds(100)),
+                          MakeTimeAccessor(&LraUnitDiskChannel::m_delay),
+                          MakeTimeChecker())
+            .AddAttribute("LossProbability",
+                          "Probability that a frame sent to an in-range device is lost.",
+                          DoubleValue(0.0),
+                          MakeDoubleAccessor(&LraUnitDiskChannel::m_lossProbability),
+                          MakeDoubleChecker<double>(0.0, 1.0));
+    return tid;
+}
+
+LraUnitDiskChannel::LraUnitDiskChannel()
+    : m_indexed(0)
+{
+    NS_LOG_FUNCTION(this);
+    m_lossRandom = CreateObject<UniformRandomVariable>();
+}
+
+LraUnitDiskChannel::~LraUnitDiskChannel()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+LraUnitDiskChannel::Add(Ptr<SimpleNetDevice> device)
+{
+    NS_LOG_FUNCTION(this << device);
+    SimpleChannel::Add(device);
+    m_devices.push_back(device);
+}
+
+void
+LraUnitDiskChannel::IndexDevices()
+{
+    if (m_indexed == m_devices.size())
+        return;
+
+    // Mobility may be installed after the devices, so the grid is filled lazily
+    if (m_indexed == 0 && m_range > 0)
+    {
+        m_grid.SetCellSize(m_range, m_range / 4);
+    }
+    for (; m_indexed < m_devices.size(); ++m_indexed)
+    {
+        Ptr<MobilityModel> mobility = m_devices[m_indexed]->GetNode()->GetObject<MobilityModel>();
+        NS_ASSERT_MSG(mobility, "LraUnitDiskChannel needs a mobility model on every node");
+        m_grid.Add(m_indexed, mobility);
+    }
+}
+
+void
+LraUnitDiskChannel::Send(Ptr<Packet> p,
+                         uint16_t protocol,
+                         Mac48Address to,
+                         Mac48Address from,
+                         Ptr<SimpleNetDevice> sender)
+{
+    NS_LOG_FUNCTION(this << p << protocol << to << from << sender);
+
+    IndexDevices();
+    Ptr<MobilityModel> senderMobility = sender->GetNode()->GetObject<MobilityModel>();
+
+    bool unicast = !to.IsBroadcast() && !to.IsGroup();
+    m_grid.ForEachCandidate(senderMobility->GetPosition(), m_range, [&](uint32_t id) {
+        Ptr<SimpleNetDevice> receiver = m_devices[id];
+        if (receiver == sender)
+            return;
+        // Nobody else would accept a unicast frame, skip the event altogether
+        if (unicast && Mac48Address::ConvertFrom(receiver->GetAddress()) != to)
+            return;
+
+        Ptr<MobilityModel> receiverMobility = receiver->GetNode()->GetObject<MobilityModel>();
+        if (senderMobility->GetDistanceFrom(receiverMobility) > m_range)
+            return;
+        if (m_regionCut &&
+            m_regionCut->IsCut(senderMobility->GetPosition(), receiverMobility->GetPosition()))
+            return;
+
+        Deliver(receiver, p, protocol, to, from);
+    });
+}
+
+void
+LraUnitDiskChannel::Deliver(Ptr<SimpleNetDevice> receiver,
+                            Ptr<Packet> p,
+                            uint16_t protocol,
+                            Mac48Address to,
+                            Mac48Address from)
+{
+    if (m_lossProbability > 0 && m_lossRandom->GetValue() < m_lossProbability)
+    {
+        NS_LOG_LOGIC("Frame to node " << receiver->GetNode()->GetId() << " lost");
+        return;
+    }
+
+    Simulator::ScheduleWithContext(receiver->GetNode()->GetId(),
+                                   m_delay,
+                                   &SimpleNetDevice::Receive,
+                                   receiver,
+                                   p->Copy(),
+                                   protocol,
+                                   to,
+                                   from);
+}
+
+void
+LraUnitDiskChannel::SetRegionCut(Ptr<LraRegionCutLossModel> regionCut)
+{
+    NS_LOG_FUNCTION(this << regionCut);
+    m_regionCut = regionCut;
+}
+
+int64_t
+LraUnitDiskChannel::AssignStreams(int64_t stream)
+{
+    NS_LOG_FUNCTION(this << stream);
+    m_lossRandom->SetStream(stream);
+    return 1;
+}
+
+} // namespace ns3
@@ -0,0 +1,69 @@
+#ifndef LRA_UNIT_DISK_CHANNEL_H
+#define LRA_UNIT_DISK_CHANNEL_H
+
+#include "lra-region-cut.h"
+#include "lra-spatial-grid.h"
+
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/nstime.h"
+#include "ns3/random-variable-stream.h"
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Abstract radio channel for large-N algorithmic runs.
+ *
+ * Frames sent by a SimpleNetDevice are delivered, after a fixed delay,
+ * only to the devices whose node lies within Range meters from the sender
+ * (unit disk). Each delivery can be dropped with probability LossProbability.
+ * Frames across an active cut of the optional LraRegionCutLossModel are lost.
+ * There is no PHY/MAC modelling at all: no interference, no contention.
+ * Receivers are looked up through a LraSpatialGrid, so a transmission costs
+ * O(neighbors) instead of O(N).
+ */
+class LraUnitDiskChannel : public SimpleChannel
+{
+public:
+  static TypeId GetTypeId (void);
+  /** Constructor */
+  LraUnitDiskChannel ();
+  /** Destructor */
+  virtual ~LraUnitDiskChannel ();
+
+  // Inherited
+  virtual void Send (Ptr<Packet> p, uint16_t protocol, Mac48Address to,
+                     Mac48Address from, Ptr<SimpleNetDevice> sender);
+  virtual void Add (Ptr<SimpleNetDevice> device);
+
+  /**
+   * Assign a fixed random variable stream number to the loss process.
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned
+   */
+  int64_t AssignStreams (int64_t stream);
+
+  /// Drop the frames crossing the active cuts of this model
+  void SetRegionCut (Ptr<LraRegionCutLossModel> regionCut);
+
+private:
+  /// Put in the grid every device attached since the last transmission
+  void IndexDevices ();
+  /// Deliver a copy of the frame to the receiver if the link survives the loss draw
+  void Deliver (Ptr<SimpleNetDevice> receiver, Ptr<Packet> p, uint16_t protocol,
+                Mac48Address to, Mac48Address from);
+
+  double m_range; // Maximum distance for a successful delivery (m)
+  Time m_delay; // Propagation plus transmission delay of every frame
+  double m_lossProbability; // Probability that an in-range delivery is lost
+  Ptr<UniformRandomVariable> m_lossRandom; // Loss draws
+  Ptr<LraRegionCutLossModel> m_regionCut; // Partitioned regions, may be null
+  std::vector<Ptr<SimpleNetDevice>> m_devices; // Attached devices
+  LraSpatialGrid m_grid; // Devices indexed by position
+  uint32_t m_indexed; // Devices already in m_grid
+};
+
+} // namespace ns3
+
+#endif /* LRA_UNIT_DISK_CHANNEL_H */
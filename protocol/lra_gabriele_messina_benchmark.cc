@@ -1,40 +1,79 @@
+#include "lra-allocation-counter.h"
+#include "lra-checkpoint.h"
+#include "lra-dag-snapshot.h"
+#include "lra-grid-spectrum-channel.h"
 #include "lra-helper.h"
+#include "lra-region-cut.h"
+#include "lra-replication.h"
 #include "lra-routing-protocol.h"
+#include "lra-scenario.h"
+#include "lra-spatial-grid.h"
+#include "lra-trace-writer.h"
+#include "lra-traffic-source.h"
+#include "lra-unit-disk-channel.h"
 
+#include "ns3/aodv-module.h"
 #include "ns3/applications-module.h"
 #include "ns3/core-module.h"
 #include "ns3/csma-module.h"
+#include "ns3/dsdv-module.h"
+#include "ns3/energy-module.h"
 #include "ns3/gnuplot-helper.h"
 #include "ns3/gnuplot.h"
 #include "ns3/internet-module.h"
 #include "ns3/ipv4-l3-protocol.h"
+#include "ns3/llc-snap-header.h"
 #include "ns3/mobility-module.h"
 #include "ns3/netanim-module.h"
 #include "ns3/network-module.h"
+#include "ns3/olsr-module.h"
 #include "ns3/ping-helper.h"
 #include "ns3/ping.h"
 #include "ns3/point-to-point-module.h"
+#include "ns3/propagation-module.h"
 #include "ns3/stats-module.h"
 #include "ns3/wifi-module.h"
 #include "ns3/yans-wifi-helper.h"
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <cmath>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <set>
+#include <unistd.h>
 
 NS_LOG_COMPONENT_DEFINE("GabrieleMessina");
 
-int startDelay = 86400;
+/// Bootstrap time before traffic starts when nothing sets it, s
+const double DEFAULT_START_DELAY = 86400;
+double startDelay = DEFAULT_START_DELAY;
 
 using namespace ns3;
+// Energy classes moved to ns3::energy in recent releases, the empty declaration keeps older ones
+namespace ns3::energy
+{
+}
+using namespace ns3::energy;
 
 bool isFileEmpty(const std::string& filename) {
     std::ifstream file(filename, std::ios::ate);  // Open file in read mode, move to end
     return file.tellg() == 0;  // Check if file size is 0
 }
 
+/// Resident set size of the process in bytes, 0 where /proc is not available
+uint64_t GetResidentBytes() {
+    std::ifstream statm("/proc/self/statm");
+    uint64_t pages = 0;
+    uint64_t resident = 0;
+    if (!(statm >> pages >> resident)) {
+        return 0;
+    }
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
 auto start = std::chrono::high_resolution_clock::now();
 void PrintCheckpoint(){
     auto end = std::chrono::high_resolution_clock::now();
@@ -65,13 +104,36 @@ class LraExample
      * \param stream the output stream
      */
     void SaveResult(std::ostream& stream);
+    /**
+     * Write the confidence intervals of a replication series to stream
+     * \param stream the output stream
+     * \param metrics the statistics of the series, in GetMetrics order
+     */
+    void SaveReplicationSummary(std::ostream& stream,
+                                const std::vector<LraReplicationStatistic>& metrics);
+    /// Names of the metrics estimated by the replications
+    std::vector<std::string> GetMetricNames() const;
+    /// Values of the metrics measured by this run, in GetMetricNames order
+    std::vector<double> GetMetrics();
+    /// Maximum number of replications
+    uint32_t GetReplications() const;
+    /// Replications run before checking the confidence intervals
+    uint32_t GetMinReplications() const;
+    /// Largest accepted ratio between half width of the interval and mean
+    double GetCiTarget() const;
+    /// Confidence level of the intervals
+    double GetConfidence() const;
 
   private:
     // parameters
     /// Number of nodes
     uint32_t size;
-    /// Area side length
+    /// Number of sinks, the last nodes unless the scenario lists them
+    uint32_t sinkCount;
+    /// Area side length (width of the area if areaHeight is set)
     double step;
+    /// Area height, 0 for a square area
+    double areaHeight;
     /// Number of packets
     uint32_t n_packets;
     /// Simulation time, seconds
@@ -80,12 +142,75 @@ class LraExample
     bool pcap;
     /// Print routes if true
     bool printRoutes;
+    /// Channel model: "wifi" (802.11ac YANS), "gridwifi" (802.11ac on a spatially
+    /// indexed spectrum channel) or "unitdisk" (abstract channel)
+    std::string channelType;
+    /// Radio range of the unit disk channel, m
+    double range;
+    /// Per-frame delay of the unit disk channel, ms
+    double linkDelay;
+    /// Per-frame loss probability of the unit disk channel
+    double lossProbability;
+    /// Write the ASCII mobility trace if true
+    bool mobilityTrace;
+    /// Binary event trace file, disabled if empty
+    std::string binaryTraceFile;
+    /// Interval between DAG snapshots, s (0 disables them)
+    double dagInterval;
+    /// DAG snapshot file
+    std::string dagFile;
+    /// Report the optimal hop count computed with global knowledge if true
+    bool oracle;
+    /// Seed the routing state from the oracle instead of running discovery if true
+    bool warmStart;
+    /// Traffic: "echo" (UDP echo, npackets per node) or a LraTrafficSource model
+    /// ("cbr", "poisson", "onoff", "trace")
+    std::string trafficModel;
+    /// Initial offered rate per source
+    std::string trafficRate;
+    /// Traffic packet size, bytes
+    uint32_t packetSize;
+    /// Mean on and off periods of the onoff model, s
+    double onTime;
+    double offTime;
+    /// Input of the trace model
+    std::string trafficTraceFile;
+    /// Rate added to every source each rampInterval
+    std::string rampStep;
+    /// Time between two load increases, s (0 disables the ramp)
+    double rampInterval;
+    /// Duration of the traffic phase of the traffic engine, s
+    double trafficTime;
+    /// Attach energy sources and Wi-Fi radio energy models if true
+    bool energy;
+    /// Initial energy of every node, J
+    double initialEnergy;
+    /// Checkpoint written at the end of the bootstrap, disabled if empty
+    std::string saveCheckpointFile;
+    /// Checkpoint restored instead of running the bootstrap, disabled if empty
+    std::string loadCheckpointFile;
+    /// Maximum number of independent replications (RngRun values)
+    uint32_t replications;
+    /// Replications always run before checking the confidence intervals
+    uint32_t minReplications;
+    /// Stop once every half width is below this fraction of its mean
+    double ciTarget;
+    /// Confidence level of the intervals
+    double confidence;
+    /// Report the memory used per node by every component if true
+    bool memoryReport;
+    /// Scenario file, disabled if empty
+    std::string scenarioFile;
+    /// Routing protocol under test: "lra", "aodv", "olsr" or "dsdv"
+    std::string routing;
     /// Simulation start time in real clock
     std::chrono::time_point<std::chrono::high_resolution_clock> simulationStartTime;
 
     // network
-    /// Address of the sink node
+    /// Anycast address of the sinks, the address of the first one
     Ipv4Address m_sinkAddress;
+    /// Addresses of all the sinks, in m_sinkIndices order
+    std::vector<Ipv4Address> m_sinkAddresses;
     /// all nodes used in the example
     NodeContainer nodes;
     /// devices used in the example
@@ -97,19 +222,239 @@ class LraExample
     std::atomic_int tot_acnt{0};
     /// map to keep record of package loss per address (node)
     std::map<Ipv4Address, std::atomic_int> m_packetsSentByNodes;
+    /// binary event trace
+    LraTraceWriter m_traceWriter;
+    /// DAG snapshot file
+    LraDagSnapshotWriter m_dagWriter;
+    /// node index of every interface address
+    std::map<Ipv4Address, uint32_t> m_nodeIndexByAddress;
+    /// Distance at which two nodes hear each other, m
+    double m_radioRange;
+    /// Node positions, for the oracle neighbor search
+    LraSpatialGrid m_oracleGrid;
+    /// Hops from every node to the nearest sink found by the oracle, UINT32_MAX if unreachable
+    std::vector<uint32_t> m_oracleDepth;
+    /// Network state restored from loadCheckpointFile
+    LraCheckpoint m_checkpoint;
+
+    /// Traffic engine statistics
+    struct TrafficStats
+    {
+        uint64_t offeredBytes = 0;    ///< Application bytes sent by the sources
+        uint64_t deliveredBytes = 0;  ///< IP bytes of every packet received at the sink
+        uint64_t goodputBytes = 0;    ///< Application bytes of the first copy of each packet
+        uint64_t delivered = 0;       ///< Unique packets received at the sink
+        Time delaySum;                ///< Sum of the end-to-end delays of unique packets
+        std::vector<double> delaysMs; ///< End-to-end delay of every unique packet, ms
+        std::vector<uint64_t> offeredByWindow;   ///< offeredBytes per ramp interval
+        std::vector<uint64_t> deliveredByWindow; ///< deliveredBytes per ramp interval
+    };
+    TrafficStats m_traffic;
+
+    /// Energy spent by the radio of one node, by kind of transmission
+    struct EnergyAccount
+    {
+        double txStartEnergy = 0; ///< Radio consumption when the current transmission began, J
+        double controlShare = 0;  ///< Fraction of the current PSDU bytes that are routing control
+        double dataShare = 0;     ///< Fraction of the current PSDU bytes that are data
+        double controlJ = 0;      ///< Spent transmitting routing control messages
+        double dataJ = 0;         ///< Spent transmitting data packets
+        double macJ = 0;          ///< Spent transmitting MAC frames (acknowledgments, ...)
+        double residualJ = 0;     ///< Energy left at the end of the run
+        double consumedJ = 0;     ///< Radio consumption at the end of the run
+    };
+    std::vector<EnergyAccount> m_energyAccounts;
+    EnergySourceContainer m_energySources;
+    DeviceEnergyModelContainer m_radioEnergyModels;
+    /// Time the first node ran out of energy, negative while all are alive
+    Time m_firstDeath{Seconds(-1)};
+    /// Sequence numbers received at the sink per source, to tell duplicates
+    std::map<Ipv4Address, std::set<uint32_t>> m_received;
+    /// Start time jitter of the applications
+    Ptr<UniformRandomVariable> m_startJitter;
+    /// Resident set size after each setup phase, in order
+    std::vector<std::pair<std::string, uint64_t>> m_memoryPhases;
+    /// LRA routing state of all the nodes at the end of the run
+    LraRoutingProtocol::MemoryUsage m_routingMemory;
+    /// Scenario read from scenarioFile
+    LraScenario m_scenario;
+    /// Node index of the first sink, owner of the anycast address
+    uint32_t m_sinkIndex;
+    /// Node indices of all the sinks
+    std::vector<uint32_t> m_sinkIndices;
+    /// Data packets delivered by every sink, by node index
+    std::map<uint32_t, uint64_t> m_sinkDeliveries;
+    /// Nodes that send traffic, by node index
+    std::vector<bool> m_isSource;
+    /// Report sections to print, all if empty
+    std::set<std::string> m_metrics;
+    /// UDP port of the data packets sent to the sink
+    uint16_t m_dataPort;
+    /// Sum of the forwarders of the data packets delivered to the sink
+    uint64_t m_hopSum;
+    /// Data packets delivered to the sink
+    uint64_t m_hopPackets;
+    /// Routing control packets transmitted at the IP layer, forwarded copies included
+    uint64_t m_controlPackets;
+    /// Routing control bytes transmitted at the IP layer, IP header included
+    uint64_t m_controlBytes;
+    /// Packets transmitted at the IP layer, forwarded copies included
+    uint64_t m_ipTransmissions;
+    /// Heap allocations and IP transmissions when the traffic starts and at the end of the run
+    std::pair<LraAllocationCounts, uint64_t> m_trafficAllocations[2];
+
+    /// One injected failure or restart and the recovery that followed
+    struct FailureRecord
+    {
+        double time = 0;              ///< Injection time, s
+        std::string kind;             ///< "crash", "region", "restart" or "heal"
+        std::vector<uint32_t> nodes;  ///< Nodes that went down, came back or were cut off
+        double reconvergedAt = -1;    ///< Time of the first converged probe, negative if none
+        double deadline = 0;          ///< Probing gives up at this time, s
+        bool closed = false;          ///< Reconverged or given up
+        uint64_t reversalsAtStart = 0; ///< Reversals of all the nodes at injection
+        uint64_t reversals = 0;       ///< Reversals until reconvergence or the deadline
+        std::vector<std::pair<Ipv4Address, uint32_t>> sent; ///< Data packets sent meanwhile
+    };
+    std::vector<FailureRecord> m_failureRecords;
+    /// Nodes whose interface is down, by node index
+    std::vector<bool> m_isDown;
+    /// Next reconvergence probe
+    EventId m_failureProbe;
+    /// Links cut by the region failures, null without any
+    Ptr<LraRegionCutLossModel> m_regionCut;
   private:
     /// Create the nodes
     void CreateNodes();
     /// Create the devices
     void CreateDevices();
+    /// Create the 802.11ac devices
+    void CreateWifiDevices();
+    /// Create the abstract unit disk channel devices
+    void CreateUnitDiskDevices();
     /// Create the network
     void InstallInternetStack();
     /// Create the simulation applications
     void InstallApplications();
+    /// Create the UDP echo clients and servers
+    void InstallEchoApplications();
+    /// Create the traffic engine sources and the sink
+    void InstallTrafficApplications();
+    /// Ramp interval index of the current time
+    size_t GetTrafficWindow() const;
     /// Init LRA nodes
     void InitNodesRouting();
+    /// Neighbors of every node at the current positions, by node index
+    std::vector<std::vector<uint32_t>> GetOracleNeighbors();
+    /// Breadth first search from the sink over the given unit disk graph
+    void ComputeOracle(const std::vector<std::vector<uint32_t>>& neighbors);
+    /// Links of node i oriented along the oracle shortest path DAG
+    std::vector<std::pair<Ipv4Address, int>> GetOracleLinks(
+        uint32_t i,
+        const std::vector<std::vector<uint32_t>>& neighbors);
+    /// Average number of forwarders between a node and the sink over reachable nodes
+    double GetOracleAverageHopCount() const;
     /// Make nodes move around
     void OnInitializeComplete();
+    /// Write positions and routing state of every node to saveCheckpointFile
+    void SaveCheckpoint();
+
+    /// Schedule the failures of the scenario
+    void ScheduleFailures();
+    /// Take down the interfaces of the nodes of a crash, or cut the links of a region
+    void InjectFailure(size_t index);
+    /// Bring the interfaces of failed nodes up again
+    void RestoreNodes(std::vector<uint32_t> restored);
+    /// Restore the links across the border of the region of a scenario failure
+    void HealRegion(size_t index);
+    /// Nodes inside the region of a scenario failure at their current positions
+    std::vector<uint32_t> GetNodesInRegion(const LraScenarioFailure& failure) const;
+    /// Whether the link between two nodes crosses an active region cut
+    bool IsCutOff(uint32_t i, uint32_t j) const;
+    /**
+     * Tell the live nodes that their links matching a predicate are gone, as their link
+     * layer would, instead of leaving it to their ACK timeouts.
+     * \param lost true for the links (node, neighbor) that failed
+     */
+    void NotifyLostLinks(const std::function<bool(uint32_t, uint32_t)>& lost);
+    /**
+     * Start measuring the recovery from a failure or restart.
+     * \param kind "crash", "region", "restart" or "heal"
+     * \param affected the nodes that went down or came back
+     * \param downtime time before the failure ends, s, 0 if it never does
+     */
+    void OpenFailureRecord(const std::string& kind,
+                           const std::vector<uint32_t>& affected,
+                           double downtime);
+    /**
+     * Close the records of the failures the network recovered from. Recovered means: the
+     * DAG of the live nodes is converged, no live node keeps a link that is not incoming
+     * toward a down or cut off node, and every restarted node has links again. A record
+     * still open when its failure ends, or when traffic ends, is closed as not reconverged.
+     */
+    void ProbeReconvergence();
+    /// Full link reversals of all the nodes so far
+    uint64_t GetTotalReversals() const;
+
+    /// Attach energy sources and radio energy models, then account transmissions
+    void InstallEnergyModels();
+    void TracePsduTxBegin(std::string ctx,
+                          WifiConstPsduMap psdus,
+                          WifiTxVector txVector,
+                          double txPowerW);
+    void TracePhyTxEnd(std::string ctx, Ptr<const Packet> packet);
+    void TraceRemainingEnergy(std::string ctx, double oldValue, double newValue);
+
+    /// Record the resident set size at the end of a phase, if memoryReport
+    void SampleMemory(const std::string& phase);
+    /// Record the heap allocations and IP transmissions so far, 0 at traffic start, 1 at the end
+    void SampleAllocations(size_t slot);
+    /// Override the parameters given by the scenario file
+    bool ApplyScenario();
+    /// Initial node positions of the scenario placement
+    Ptr<ListPositionAllocator> GetScenarioPositions(double width, double height);
+    /// Whether a report section is printed
+    bool Emits(const std::string& metric) const;
+    /// Whether the routing protocol under test is LRA
+    bool IsLra() const;
+    /// Time after which no source sends any more, s
+    double GetTrafficEnd() const;
+    /**
+     * Whether an IP packet carries control traffic of the routing protocol under test
+     * \param header the IP header
+     * \param payload the packet without its IP header
+     */
+    bool IsRoutingControl(const Ipv4Header& header, Ptr<const Packet> payload) const;
+    /// Average number of forwarders of the data packets delivered to the sink
+    double GetAverageHopCount() const;
+    void TraceSinkDelivery(std::string ctx,
+                           const Ipv4Header& header,
+                           Ptr<const Packet> packet,
+                           uint32_t interface);
+    void TraceIpTx(std::string ctx, Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
+
+    /// Start periodic DAG snapshots
+    void EnableDagSnapshots();
+    /// Capture the global link graph and schedule the next capture until traffic ends
+    void TakeDagSnapshot();
+    /// Connect the binary event trace to mobility and routing trace sources
+    void EnableBinaryTrace();
+    /// Build a trace record for the node in the context
+    LraTraceRecord MakeTraceRecord(std::string ctx, LraTraceEventType type);
+    void TraceCourseChange(std::string ctx, Ptr<const MobilityModel> mobility);
+    void TraceLinkState(std::string ctx, Ipv4Address neighbor, int oldState, int newState);
+    void TraceReversal(std::string ctx, uint32_t reversedLinks);
+    void TraceForward(std::string ctx,
+                      Ptr<const Packet> packet,
+                      const Ipv4Header& header,
+                      Ipv4Address nextHop);
+    void TraceDrop(std::string ctx,
+                   Ptr<const Packet> packet,
+                   const Ipv4Header& header,
+                   LraDropReason reason);
+    void TraceLoop(std::string ctx, Ipv4Address suspect);
+    void TracePartition(std::string ctx, Ipv4Address origin);
+    void TraceRejoin(std::string ctx, Ipv4Address neighbor);
 
     /// Tracing methods and utils
     void LogMessageResponse(std::string ctx,
@@ -120,6 +465,8 @@ class LraExample
                         Ptr<const Packet> packet,
                         const Address& srcAddress,
                         const Address& destAddress);
+    void LogTrafficSend(std::string ctx, Ptr<const Packet> packet);
+    void LogTrafficReceive(std::string ctx, Ptr<const Packet> packet, const Address& from);
     uint32_t GetNodeIdFromContext(std::string ctx);
     Ipv4Address GetNodeAddressFromId(uint32_t id);
     uint32_t GetApplicationIndexFromContext(std::string ctx);
@@ -132,47 +479,154 @@ main(int argc, char** argv)
     // LogComponentEnable ("UdpEchoServerApplication", LOG_LEVEL_ALL);
     // LogComponentEnable ("LraRoutingProtocol", LOG_LEVEL_INFO);
     std::string csvFileName = "./gnuplot/data_results.csv";
+    std::string replicationFileName = "./gnuplot/replication_results.csv";
 
-    start = std::chrono::high_resolution_clock::now();
-
-    LraExample test;
-    if (!test.Configure(argc, argv))
+    std::vector<LraReplicationStatistic> metrics;
+    uint64_t baseRun = 0;
+    for (uint32_t replication = 0;; ++replication)
     {
-        NS_FATAL_ERROR("Configuration failed. Aborted.");
-    }
+        start = std::chrono::high_resolution_clock::now();
+
+        LraExample test;
+        if (!test.Configure(argc, argv))
+        {
+            NS_FATAL_ERROR("Configuration failed. Aborted.");
+        }
+        if (replication == 0)
+        {
+            baseRun = RngSeedManager::GetRun();
+            for (const auto& name : test.GetMetricNames())
+            {
+                metrics.emplace_back(name);
+            }
+        }
+        // Independent replications differ only by the run number
+        SeedManager::SetRun(baseRun + replication);
+        if (test.GetReplications() > 1)
+        {
+            std::cout << "Replication " << replication + 1 << " (RngRun " << baseRun + replication
+                      << ")\n";
+        }
 
-    test.Run();
-    test.Report(std::cout);
+        test.Run();
+        test.Report(std::cout);
 
-    // Calculate real execution time
-    auto end = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> elapsed = end - start;
-    std::cout << "Simulation time: " << elapsed.count() << " seconds."
-                << std::endl;
+        // Calculate real execution time
+        auto end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> elapsed = end - start;
+        std::cout << "Simulation time: " << elapsed.count() << " seconds." << std::endl;
 
-    std::ofstream file(csvFileName, std::ios::app);
-    if (!file) {
-        std::cerr << "Error opening file!" << std::endl;
-    }
-    else{
-        bool empty = isFileEmpty(csvFileName);
-        if (empty) {
-            file << "n_nodes,area_side,packets_per_node,tot_packets,n_package_loss,loss_percentage,averageHop,simulation_time,real_elapsed_time\n";
+        std::ofstream file(csvFileName, std::ios::app);
+        if (!file)
+        {
+            std::cerr << "Error opening file!" << std::endl;
+        }
+        else
+        {
+            bool empty = isFileEmpty(csvFileName);
+            if (empty)
+            {
+                file << "n_nodes,area_side,packets_per_node,tot_packets,n_package_loss,loss_percentage,averageHop,simulation_time,real_elapsed_time,delay_ms,control_packets,control_bytes,routing\n";
+            }
+            test.SaveResult(file);
+            file.close();
+        }
+
+        if (test.GetReplications() <= 1)
+        {
+            break;
+        }
+
+        std::vector<double> values = test.GetMetrics();
+        bool converged = replication + 1 >= test.GetMinReplications();
+        for (size_t i = 0; i < metrics.size(); ++i)
+        {
+            metrics[i].Add(values[i]);
+            converged = converged && metrics[i].IsConverged(test.GetConfidence(), test.GetCiTarget());
+        }
+        if (!converged && replication + 1 < test.GetReplications())
+        {
+            continue;
+        }
+
+        std::cout << "Replications: " << replication + 1
+                  << (converged ? " (confidence intervals within target)"
+                                : " (cap reached before the target)")
+                  << std::endl;
+        for (const auto& metric : metrics)
+        {
+            std::cout << metric.GetName() << ": " << metric.GetMean() << " +/- "
+                      << metric.GetHalfWidth(test.GetConfidence()) << " ("
+                      << test.GetConfidence() * 100 << "% confidence)" << std::endl;
         }
-        test.SaveResult(file);
-        file.close();
+        std::ofstream summary(replicationFileName, std::ios::app);
+        if (!summary)
+        {
+            std::cerr << "Error opening file!" << std::endl;
+        }
+        else
+        {
+            if (isFileEmpty(replicationFileName))
+            {
+                summary << "n_nodes,area_side,packets_per_node,traffic,metric,replications,mean,"
+                           "ci_half_width,confidence,converged,routing\n";
+            }
+            test.SaveReplicationSummary(summary, metrics);
+        }
+        break;
     }
     return 0;
 }
 
 LraExample::LraExample()
     : size(10),
+      sinkCount(1),
       step(10),
+      areaHeight(0),
       n_packets(3),
       totalTime(10),
       pcap(false),
-      printRoutes(true)
+      printRoutes(true),
+      channelType("wifi"),
+      range(100),
+      linkDelay(0.1),
+      lossProbability(0),
+      mobilityTrace(true),
+      binaryTraceFile(""),
+      dagInterval(0),
+      dagFile("lra-dag.snap"),
+      oracle(false),
+      warmStart(false),
+      trafficModel("echo"),
+      trafficRate("16kbps"),
+      packetSize(512),
+      onTime(1),
+      offTime(1),
+      trafficTraceFile(""),
+      rampStep("0bps"),
+      rampInterval(0),
+      trafficTime(60),
+      energy(false),
+      initialEnergy(100),
+      saveCheckpointFile(""),
+      loadCheckpointFile(""),
+      replications(1),
+      minReplications(3),
+      ciTarget(0.05),
+      confidence(0.95),
+      memoryReport(false),
+      scenarioFile(""),
+      routing("lra"),
+      m_radioRange(0),
+      m_sinkIndex(0),
+      m_dataPort(0),
+      m_hopSum(0),
+      m_hopPackets(0),
+      m_controlPackets(0),
+      m_controlBytes(0),
+      m_ipTransmissions(0)
 {
+    m_startJitter = CreateObject<UniformRandomVariable>();
 }
 
 bool
@@ -184,27 +638,316 @@ LraExample::Configure(int argc, char** argv)
     cmd.AddValue("pcap", "Write PCAP traces.", pcap);
     cmd.AddValue("printRoutes", "Print routing table dumps.", printRoutes);
     cmd.AddValue("size", "Number of nodes.", size);
+    cmd.AddValue("sinks", "Number of sinks (the last nodes), one anycast destination.", sinkCount);
     cmd.AddValue("npackets", "Number packets.", n_packets);
     cmd.AddValue("time", "Simulation time, s.", totalTime);
     cmd.AddValue("side", "Simulation Area side length, m", step);
+    cmd.AddValue("startDelay", "Bootstrap time before traffic starts, s.", startDelay);
+    cmd.AddValue("channel", "Channel model: wifi, gridwifi or unitdisk.", channelType);
+    cmd.AddValue("range", "Unit disk channel range, m.", range);
+    cmd.AddValue("linkDelay", "Unit disk channel per-frame delay, ms.", linkDelay);
+    cmd.AddValue("lossProb", "Unit disk channel per-frame loss probability.", lossProbability);
+    cmd.AddValue("mobilityTrace", "Write the ASCII mobility trace.", mobilityTrace);
+    cmd.AddValue("binaryTrace", "Write a binary event trace to this file.", binaryTraceFile);
+    cmd.AddValue("dagInterval", "Interval between DAG snapshots, s (0 = off).", dagInterval);
+    cmd.AddValue("dagFile", "DAG snapshot file.", dagFile);
+    cmd.AddValue("oracle", "Report the optimal hop count from global knowledge.", oracle);
+    cmd.AddValue("warmStart", "Seed link states from the oracle, skipping discovery.", warmStart);
+    cmd.AddValue("traffic", "Traffic: echo, cbr, poisson, onoff or trace.", trafficModel);
+    cmd.AddValue("rate", "Initial offered rate per source (traffic engine).", trafficRate);
+    cmd.AddValue("packetSize", "Packet size, bytes (traffic engine).", packetSize);
+    cmd.AddValue("onTime", "Mean burst duration of the onoff model, s.", onTime);
+    cmd.AddValue("offTime", "Mean silence duration of the onoff model, s.", offTime);
+    cmd.AddValue("trafficTrace", "Input of the trace model: '<time s> <size bytes>' lines.",
+                 trafficTraceFile);
+    cmd.AddValue("rampStep", "Rate added to every source each rampInterval.", rampStep);
+    cmd.AddValue("rampInterval", "Time between two load increases, s (0 = off).", rampInterval);
+    cmd.AddValue("trafficTime", "Duration of the traffic engine phase, s.", trafficTime);
+    cmd.AddValue("energy", "Attach energy sources and Wi-Fi radio energy models.", energy);
+    cmd.AddValue("initialEnergy", "Initial energy of every node, J.", initialEnergy);
+    cmd.AddValue("saveCheckpoint",
+                 "Write positions and routing state to this file at the end of the bootstrap.",
+                 saveCheckpointFile);
+    cmd.AddValue("loadCheckpoint",
+                 "Restore positions and routing state from this file, skipping the bootstrap.",
+                 loadCheckpointFile);
+    cmd.AddValue("replications",
+                 "Maximum number of independent replications (consecutive RngRun values).",
+                 replications);
+    cmd.AddValue("minReplications",
+                 "Replications run before checking the confidence intervals.",
+                 minReplications);
+    cmd.AddValue("ciTarget",
+                 "Stop replicating when every half width is below this fraction of its mean.",
+                 ciTarget);
+    cmd.AddValue("confidence", "Confidence level of the replication intervals.", confidence);
+    cmd.AddValue("memory", "Report the memory used per node by every component.", memoryReport);
+    cmd.AddValue("routing", "Routing protocol: lra, aodv, olsr or dsdv.", routing);
+    cmd.AddValue("scenario",
+                 "Scenario file; its settings override the corresponding options.",
+                 scenarioFile);
 
     cmd.Parse(argc, argv);
+
+    if (!scenarioFile.empty() && !ApplyScenario())
+    {
+        return false;
+    }
+
+    if (!loadCheckpointFile.empty())
+    {
+        if (!m_checkpoint.Load(loadCheckpointFile))
+        {
+            std::cerr << "Cannot read checkpoint '" << loadCheckpointFile << "'." << std::endl;
+            return false;
+        }
+        // The topology comes from the checkpoint
+        size = m_checkpoint.nodes.size();
+        warmStart = false;
+        // The state is restored at once, the bootstrap wait is only kept if asked for
+        if (startDelay == DEFAULT_START_DELAY)
+        {
+            startDelay = 1;
+        }
+        std::cout << "Restoring " << size << " nodes from " << loadCheckpointFile << "\n";
+    }
+
+    if (trafficModel != "echo" && trafficModel != "cbr" && trafficModel != "poisson" &&
+        trafficModel != "onoff" && trafficModel != "trace")
+    {
+        std::cerr << "Unknown traffic '" << trafficModel
+                  << "', use echo, cbr, poisson, onoff or trace." << std::endl;
+        return false;
+    }
+    if (channelType != "wifi" && channelType != "gridwifi" && channelType != "unitdisk")
+    {
+        std::cerr << "Unknown channel '" << channelType << "', use wifi, gridwifi or unitdisk."
+                  << std::endl;
+        return false;
+    }
+    if (routing != "lra" && routing != "aodv" && routing != "olsr" && routing != "dsdv")
+    {
+        std::cerr << "Unknown routing '" << routing << "', use lra, aodv, olsr or dsdv."
+                  << std::endl;
+        return false;
+    }
+    if (!IsLra() && (warmStart || !loadCheckpointFile.empty() || !saveCheckpointFile.empty() ||
+                     dagInterval > 0 || !m_scenario.failures.empty()))
+    {
+        std::cerr << "Warm start, checkpoints, DAG snapshots and failure injection need "
+                     "--routing=lra."
+                  << std::endl;
+        return false;
+    }
+    if (confidence <= 0 || confidence >= 1)
+    {
+        std::cerr << "The confidence level must be between 0 and 1." << std::endl;
+        return false;
+    }
+    minReplications = std::max(minReplications, 2u);
+
+    // The last nodes are the sinks unless the scenario says otherwise, the others send traffic
+    if (sinkCount == 0 || sinkCount >= size)
+    {
+        std::cerr << "The number of sinks must be between 1 and " << size - 1 << "." << std::endl;
+        return false;
+    }
+    m_sinkIndices = m_scenario.sinks;
+    for (uint32_t i = size - sinkCount; m_sinkIndices.empty() && i < size; ++i)
+    {
+        m_sinkIndices.push_back(i);
+    }
+    // The scenario may repeat a sink
+    std::sort(m_sinkIndices.begin(), m_sinkIndices.end());
+    m_sinkIndices.erase(std::unique(m_sinkIndices.begin(), m_sinkIndices.end()),
+                        m_sinkIndices.end());
+    // The first one listed owns the anycast address
+    m_sinkIndex = m_scenario.sinks.empty() ? m_sinkIndices.front() : m_scenario.sinks.front();
+    auto outOfRange = [this](uint32_t index) { return index >= size; };
+    // A checkpoint may restore fewer nodes than the scenario declares
+    if (std::any_of(m_sinkIndices.begin(), m_sinkIndices.end(), outOfRange) ||
+        std::any_of(m_scenario.sources.begin(), m_scenario.sources.end(), outOfRange) ||
+        std::any_of(m_scenario.failures.begin(),
+                    m_scenario.failures.end(),
+                    [&outOfRange](const LraScenarioFailure& failure) {
+                        return std::any_of(failure.nodes.begin(), failure.nodes.end(), outOfRange);
+                    }))
+    {
+        std::cerr << "The scenario sinks, sources and failing nodes must be below " << size << "."
+                  << std::endl;
+        return false;
+    }
+    if (!IsLra() && m_sinkIndices.size() > 1)
+    {
+        std::cerr << "Several sinks need --routing=lra, the other protocols have no anycast."
+                  << std::endl;
+        return false;
+    }
+    m_isSource.assign(size, m_scenario.sources.empty() || m_scenario.allSources);
+    for (uint32_t source : m_scenario.sources)
+    {
+        m_isSource[source] = true;
+    }
+    for (uint32_t sink : m_sinkIndices)
+    {
+        m_isSource[sink] = false;
+        m_sinkDeliveries[sink] = 0;
+    }
+    return true;
+}
+
+bool
+LraExample::ApplyScenario()
+{
+    std::string error;
+    if (!m_scenario.Load(scenarioFile, error))
+    {
+        std::cerr << "Invalid scenario: " << error << std::endl;
+        return false;
+    }
+    if (m_scenario.nodeCount > 0)
+    {
+        size = m_scenario.nodeCount;
+    }
+    if (m_scenario.width > 0)
+    {
+        step = m_scenario.width;
+        areaHeight = m_scenario.height;
+    }
+    else if (!m_scenario.positions.empty())
+    {
+        // Explicit positions without an area: the smallest area holding them
+        double width = 0;
+        double height = 0;
+        for (const auto& position : m_scenario.positions)
+        {
+            width = std::max(width, position.x);
+            height = std::max(height, position.y);
+        }
+        step = std::max(width, 1.0);
+        areaHeight = std::max(height, 1.0);
+    }
+    if (!m_scenario.channel.empty())
+    {
+        channelType = m_scenario.channel;
+    }
+    if (m_scenario.range > 0)
+    {
+        range = m_scenario.range;
+    }
+    if (!m_scenario.traffic.empty())
+    {
+        trafficModel = m_scenario.traffic;
+    }
+    if (!m_scenario.rate.empty())
+    {
+        trafficRate = m_scenario.rate;
+    }
+    if (m_scenario.packetSize > 0)
+    {
+        packetSize = m_scenario.packetSize;
+    }
+    if (m_scenario.start >= 0)
+    {
+        startDelay = m_scenario.start;
+    }
+    if (m_scenario.duration >= 0)
+    {
+        trafficTime = m_scenario.duration;
+    }
+    for (const auto& metric : m_scenario.metrics)
+    {
+        if (metric != "loss" && metric != "hops" && metric != "control" && metric != "traffic" &&
+            metric != "energy" && metric != "memory" && metric != "oracle" && metric != "sinks" &&
+            metric != "failures")
+        {
+            std::cerr << "Unknown metric '" << metric
+                      << "', use loss, hops, control, traffic, energy, memory, oracle, sinks or "
+                         "failures."
+                      << std::endl;
+            return false;
+        }
+        m_metrics.insert(metric);
+    }
+    // Metrics that need extra models turn them on
+    energy = energy || m_metrics.count("energy");
+    memoryReport = memoryReport || m_metrics.count("memory");
+    oracle = oracle || m_metrics.count("oracle");
+
+    std::cout << "Scenario " << scenarioFile << ": " << size << " nodes, "
+              << m_scenario.positions.size() << " explicit positions\n";
     return true;
 }
 
+bool
+LraExample::Emits(const std::string& metric) const
+{
+    return m_metrics.empty() || m_metrics.count(metric);
+}
+
+bool
+LraExample::IsLra() const
+{
+    return routing == "lra";
+}
+
+double
+LraExample::GetTrafficEnd() const
+{
+    // Echo clients start within 1000 s of the bootstrap and send one packet per second
+    if (trafficModel == "echo")
+    {
+        return startDelay + 1000 + n_packets;
+    }
+    return startDelay + trafficTime;
+}
+
 void
 LraExample::Run()
 {
     simulationStartTime = std::chrono::high_resolution_clock::now();
-    totalTime = 4000000000;
+    // Counting every allocation of the process costs, only the memory report pays for it
+    LraSetAllocationCounting(memoryReport);
+    // Echo clients stop by themselves, the traffic engine runs for trafficTime plus a drain second
+    totalTime = (trafficModel == "echo") ? 4000000000 : startDelay + trafficTime + 1;
 
     Time jitter = Time(Seconds(startDelay));
     Simulator::Schedule(jitter, &LraExample::OnInitializeComplete, this);
 
+    SampleMemory("start");
     CreateNodes();
+    SampleMemory("nodes and mobility");
     CreateDevices();
+    SampleMemory("devices and channel");
     InstallInternetStack();
+    SampleMemory("internet stack and LRA");
     InstallApplications();
+    if (energy)
+    {
+        InstallEnergyModels();
+    }
+    SampleMemory("applications");
+
+    if (!binaryTraceFile.empty())
+    {
+        EnableBinaryTrace();
+    }
+    if (dagInterval > 0)
+    {
+        EnableDagSnapshots();
+    }
+    if (!saveCheckpointFile.empty())
+    {
+        Simulator::Schedule(Seconds(startDelay), &LraExample::SaveCheckpoint, this);
+    }
+    if (memoryReport)
+    {
+        Simulator::Schedule(Seconds(startDelay), &LraExample::SampleAllocations, this, 0);
+    }
+    if (!m_scenario.failures.empty())
+    {
+        ScheduleFailures();
+    }
 
     Config::DisconnectWithoutContext(
         "/NodeList/*/ApplicationList/*/$ns3::UdpEchoServer/RxWithAddresses",
@@ -216,7 +959,7 @@ LraExample::Run()
     if (printRoutes)
     {
         Ptr<OutputStreamWrapper> routingStream =
-            Create<OutputStreamWrapper>("lra.final.routes", std::ios::out);
+            Create<OutputStreamWrapper>(routing + ".final.routes", std::ios::out);
         Ipv4RoutingHelper::PrintRoutingTableAllAt(Seconds(totalTime), routingStream);
     }
 
@@ -226,6 +969,37 @@ LraExample::Run()
 
     Simulator::Run();
 
+    if (memoryReport)
+    {
+        // Events, packets in flight and routing state grown while running
+        SampleMemory("simulation");
+        SampleAllocations(1);
+        for (uint32_t i = 0; i < nodes.GetN() && IsLra(); ++i)
+        {
+            auto usage = nodes.Get(i)->GetObject<LraRoutingProtocol>()->GetMemoryUsage();
+            m_routingMemory.object += usage.object;
+            m_routingMemory.neighbors += usage.neighbors;
+            m_routingMemory.reverseRoutes += usage.reverseRoutes;
+            m_routingMemory.linkTimers += usage.linkTimers;
+            m_routingMemory.aggregation += usage.aggregation;
+        }
+    }
+
+    // The energy models update themselves from Now(), which Destroy resets to 0
+    for (uint32_t i = 0; i < m_energySources.GetN(); ++i)
+    {
+        m_energyAccounts[i].residualJ = m_energySources.Get(i)->GetRemainingEnergy();
+        m_energyAccounts[i].consumedJ = m_radioEnergyModels.Get(i)->GetTotalEnergyConsumption();
+    }
+
+    if (m_traceWriter.IsOpen())
+    {
+        std::cout << "Binary trace: " << m_traceWriter.GetRecordCount() << " events written to "
+                  << binaryTraceFile << "\n";
+        m_traceWriter.Close();
+    }
+    m_dagWriter.Close();
+
     Simulator::Destroy();
     Names::Clear();
 }
@@ -243,9 +1017,10 @@ LraExample::SaveResult(std::ostream& stream)
     auto end = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> elapsed = end - simulationStartTime;
 
-    Ptr<Node> node = nodes.Get(nodes.GetN()-1);
-    Ptr<LraRoutingProtocol> lraRouting = node->GetObject<LraRoutingProtocol>();
-    auto averageHop = lraRouting->GetAverageHopCount();
+    auto averageHop = GetAverageHopCount();
+    double delay = m_traffic.delivered > 0
+                       ? m_traffic.delaySum.GetSeconds() * 1000 / m_traffic.delivered
+                       : 0;
 
     stream<<size<<",";
     stream<<step<<",";
@@ -255,24 +1030,347 @@ LraExample::SaveResult(std::ostream& stream)
     stream<<loss<<",";
     stream<<averageHop<<",";
     stream<<totalTime<<",";
-    stream<<elapsed.count();
+    stream<<elapsed.count()<<",";
+    stream<<delay<<",";
+    stream<<m_controlPackets<<",";
+    stream<<m_controlBytes<<",";
+    stream<<routing;
     stream<<std::endl;
 }
 
 void
-LraExample::Report(std::ostream&)
+LraExample::SaveReplicationSummary(std::ostream& stream,
+                                   const std::vector<LraReplicationStatistic>& metrics)
+{
+    bool converged = true;
+    for (const auto& metric : metrics)
+    {
+        converged = converged && metric.IsConverged(confidence, ciTarget);
+    }
+    for (const auto& metric : metrics)
+    {
+        stream << size << "," << step << "," << n_packets << "," << trafficModel << ","
+               << metric.GetName() << "," << metric.GetCount() << "," << metric.GetMean() << ","
+               << metric.GetHalfWidth(confidence) << "," << confidence << "," << converged << ","
+               << routing << std::endl;
+    }
+}
+
+std::vector<std::string>
+LraExample::GetMetricNames() const
 {
-    std::cout << "Packages lost:" << std::endl;
+    // The echo applications do not timestamp their packets
+    if (trafficModel == "echo")
+    {
+        return {"loss_percentage", "averageHop", "control_packets"};
+    }
+    return {"loss_percentage", "averageHop", "control_packets", "delay_ms"};
+}
 
+std::vector<double>
+LraExample::GetMetrics()
+{
     int total_loss = 0;
     for (const auto& pair : m_packetsSentByNodes)
     {
-        std::cout << "Node Ip: " << pair.first << ", Packets Lost: " << pair.second << std::endl;
         total_loss += pair.second;
     }
+    std::vector<double> values;
+    values.push_back(tot_acnt > 0 ? ((double)total_loss / tot_acnt) * 100.0 : 0);
+    values.push_back(GetAverageHopCount());
+    values.push_back(m_controlPackets);
+    if (trafficModel != "echo")
+    {
+        values.push_back(m_traffic.delivered > 0
+                             ? m_traffic.delaySum.GetSeconds() * 1000 / m_traffic.delivered
+                             : 0);
+    }
+    return values;
+}
+
+uint32_t
+LraExample::GetReplications() const
+{
+    return replications;
+}
+
+uint32_t
+LraExample::GetMinReplications() const
+{
+    return minReplications;
+}
+
+double
+LraExample::GetCiTarget() const
+{
+    return ciTarget;
+}
+
+double
+LraExample::GetConfidence() const
+{
+    return confidence;
+}
+
+void
+LraExample::Report(std::ostream&)
+{
+    if (Emits("loss"))
+    {
+        std::cout << "Packages lost:" << std::endl;
+
+        int total_loss = 0;
+        for (const auto& pair : m_packetsSentByNodes)
+        {
+            std::cout << "Node Ip: " << pair.first << ", Packets Lost: " << pair.second
+                      << std::endl;
+            total_loss += pair.second;
+        }
+
+        std::cout << "Total packets:" << tot_acnt << ", Total packets lost: " << total_loss
+                  << ", Loss(%): " << ((double)total_loss / tot_acnt) * 100.0 << std::endl;
+    }
+    if (m_metrics.count("hops"))
+    {
+        // Printed with the oracle comparison otherwise, so only on request
+        std::cout << "Average hop count: " << GetAverageHopCount() << std::endl;
+    }
+
+    if (Emits("control"))
+    {
+        std::cout << "Routing control (" << routing << "): " << m_controlPackets
+                  << " packets, " << m_controlBytes << " bytes transmitted" << std::endl;
+    }
+
+    uint64_t controlReceived = 0;
+    uint64_t duplicates = 0;
+    uint64_t aggregateFrames = 0;
+    uint64_t aggregatedPackets = 0;
+    uint64_t reversals = 0;
+    uint64_t probesSuppressed = 0;
+    uint64_t partitions = 0;
+    uint64_t rejoins = 0;
+    uint32_t partitioned = 0;
+    for (uint32_t i = 0; i < nodes.GetN() && IsLra(); ++i)
+    {
+        Ptr<LraRoutingProtocol> lraRouting = nodes.Get(i)->GetObject<LraRoutingProtocol>();
+        controlReceived += lraRouting->GetControlMessagesReceived();
+        duplicates += lraRouting->GetDuplicatesSuppressed();
+        aggregateFrames += lraRouting->GetAggregateFramesSent();
+        aggregatedPackets += lraRouting->GetAggregatedPackets();
+        reversals += lraRouting->GetReversals();
+        probesSuppressed += lraRouting->GetAckProbesSuppressed();
+        partitions += lraRouting->GetPartitions();
+        rejoins += lraRouting->GetRejoins();
+        partitioned += lraRouting->IsPartitioned();
+    }
+    if (IsLra() && Emits("control"))
+    {
+        std::cout << "Control messages processed: " << controlReceived
+                  << ", duplicates suppressed: " << duplicates << ", link reversals: " << reversals
+                  << ", ACK probes suppressed: " << probesSuppressed << std::endl;
+        std::cout << "Partitions entered: " << partitions << ", rejoins: " << rejoins
+                  << ", nodes partitioned at the end: " << partitioned << std::endl;
+    }
+    if (aggregateFrames > 0 && Emits("control"))
+    {
+        std::cout << "Aggregate frames: " << aggregateFrames << " carrying " << aggregatedPackets
+                  << " packets (" << double(aggregatedPackets) / aggregateFrames
+                  << " per frame)" << std::endl;
+    }
+
+    if (trafficModel != "echo" && Emits("traffic"))
+    {
+        double seconds = trafficTime;
+        std::cout << "Offered load: " << m_traffic.offeredBytes * 8 / seconds / 1000
+                  << " kbps, throughput: " << m_traffic.deliveredBytes * 8 / seconds / 1000
+                  << " kbps, goodput: " << m_traffic.goodputBytes * 8 / seconds / 1000
+                  << " kbps, mean delay: "
+                  << (m_traffic.delivered > 0
+                          ? m_traffic.delaySum.GetMilliSeconds() / double(m_traffic.delivered)
+                          : 0)
+                  << " ms" << std::endl;
+        if (!m_traffic.delaysMs.empty())
+        {
+            auto percentile = [this](double p) {
+                std::vector<double>& delays = m_traffic.delaysMs;
+                auto nth = delays.begin() + static_cast<size_t>(p * (delays.size() - 1));
+                std::nth_element(delays.begin(), nth, delays.end());
+                return *nth;
+            };
+            std::cout << "Delay p50: " << percentile(0.50) << " ms, p95: " << percentile(0.95)
+                      << " ms, p99: " << percentile(0.99) << " ms" << std::endl;
+        }
+        if (rampInterval > 0)
+        {
+            std::cout << "time_s,offered_kbps,throughput_kbps" << std::endl;
+            for (size_t w = 0; w < m_traffic.offeredByWindow.size(); ++w)
+            {
+                uint64_t delivered = w < m_traffic.deliveredByWindow.size()
+                                         ? m_traffic.deliveredByWindow[w]
+                                         : 0;
+                std::cout << w * rampInterval << ","
+                          << m_traffic.offeredByWindow[w] * 8 / rampInterval / 1000 << ","
+                          << delivered * 8 / rampInterval / 1000 << std::endl;
+            }
+        }
+    }
+
+    if (m_energySources.GetN() > 0 && Emits("energy"))
+    {
+        double controlJ = 0;
+        double dataJ = 0;
+        double macJ = 0;
+        std::cout << "Residual energy:" << std::endl;
+        for (uint32_t i = 0; i < m_energySources.GetN(); ++i)
+        {
+            std::cout << "Node Ip: " << GetNodeAddressFromId(i) << ", Residual energy: "
+                      << m_energyAccounts[i].residualJ << " J, Consumed: "
+                      << m_energyAccounts[i].consumedJ << " J" << std::endl;
+            controlJ += m_energyAccounts[i].controlJ;
+            dataJ += m_energyAccounts[i].dataJ;
+            macJ += m_energyAccounts[i].macJ;
+        }
+        std::cout << "Transmission energy: routing control " << controlJ << " J, data " << dataJ
+                  << " J, MAC " << macJ << " J" << std::endl;
+        if (m_firstDeath.IsNegative())
+        {
+            std::cout << "No node ran out of energy" << std::endl;
+        }
+        else
+        {
+            std::cout << "First node death at " << m_firstDeath.GetSeconds() << " s" << std::endl;
+        }
+    }
+
+    if (memoryReport && m_memoryPhases.size() > 1 && Emits("memory"))
+    {
+        double n = nodes.GetN();
+        std::cout << "Memory per node (resident set growth of each phase):" << std::endl;
+        for (size_t i = 1; i < m_memoryPhases.size(); ++i)
+        {
+            int64_t delta = int64_t(m_memoryPhases[i].second) - int64_t(m_memoryPhases[i - 1].second);
+            std::cout << "  " << m_memoryPhases[i].first << ": " << delta / n << " bytes"
+                      << std::endl;
+        }
+        std::cout << "  total: "
+                  << (int64_t(m_memoryPhases.back().second) -
+                      int64_t(m_memoryPhases.front().second)) /
+                         n
+                  << " bytes" << std::endl;
+        std::cout << "LRA routing state per node (0 with other protocols): object " << m_routingMemory.object / n
+                  << ", neighbor table " << m_routingMemory.neighbors / n << ", reverse routes "
+                  << m_routingMemory.reverseRoutes / n << ", link timers "
+                  << m_routingMemory.linkTimers / n << ", aggregation "
+                  << m_routingMemory.aggregation / n << " bytes" << std::endl;
+
+        // Whole process, packets, events and the tracing of this benchmark included
+        uint64_t allocations = m_trafficAllocations[1].first.allocations -
+                               m_trafficAllocations[0].first.allocations;
+        uint64_t bytes = m_trafficAllocations[1].first.bytes - m_trafficAllocations[0].first.bytes;
+        uint64_t transmissions = m_trafficAllocations[1].second - m_trafficAllocations[0].second;
+        std::cout << "Heap allocations after the bootstrap: " << allocations << " (" << bytes
+                  << " bytes), "
+                  << (transmissions > 0 ? double(allocations) / transmissions : 0)
+                  << " per IP transmission" << std::endl;
+    }
+
+    if (oracle && Emits("oracle"))
+    {
+        std::cout << "Average hop count: " << GetAverageHopCount()
+                  << ", optimal (initial topology): " << GetOracleAverageHopCount() << std::endl;
+    }
+
+    if (!m_failureRecords.empty() && Emits("failures"))
+    {
+        double reconvergenceSum = 0;
+        uint32_t reconverged = 0;
+        uint64_t lostSum = 0;
+        uint64_t reversals = GetTotalReversals();
+        std::cout << "Failures:" << std::endl;
+        for (auto& record : m_failureRecords)
+        {
+            std::cout << "  " << record.time << " s " << record.kind << " of "
+                      << record.nodes.size() << " nodes: ";
+            if (record.reconvergedAt >= 0)
+            {
+                std::cout << "reconverged in " << record.reconvergedAt - record.time << " s";
+                reconvergenceSum += record.reconvergedAt - record.time;
+                reconverged++;
+            }
+            else
+            {
+                std::cout << "not reconverged";
+                if (record.closed)
+                {
+                    std::cout << " within " << record.deadline - record.time << " s";
+                }
+                else
+                {
+                    record.reversals = reversals - record.reversalsAtStart;
+                }
+            }
+            std::cout << ", " << record.reversals << " reversals";
+            if (trafficModel != "echo")
+            {
+                // The echo clients carry no sequence number
+                uint64_t lost = 0;
+                for (const auto& packet : record.sent)
+                {
+                    lost += m_received[packet.first].count(packet.second) == 0;
+                }
+                lostSum += lost;
+                std::cout << ", " << lost << "/" << record.sent.size() << " packets lost";
+            }
+            std::cout << std::endl;
+        }
+        std::cout << "Mean reconvergence: "
+                  << (reconverged > 0 ? reconvergenceSum / reconverged : 0) << " s over "
+                  << reconverged << " of " << m_failureRecords.size() << " events";
+        if (trafficModel != "echo")
+        {
+            std::cout << ", mean packets lost per event: "
+                      << double(lostSum) / m_failureRecords.size();
+        }
+        std::cout << std::endl;
+    }
+
+    if (m_sinkIndices.size() > 1 && Emits("sinks"))
+    {
+        // Jain's index: 1 when the sinks share the load evenly, 1/n when one takes it all
+        double sum = 0;
+        double squares = 0;
+        for (const auto& sink : m_sinkDeliveries)
+        {
+            sum += sink.second;
+            squares += double(sink.second) * sink.second;
+        }
+        std::cout << "Sink load:" << std::endl;
+        for (const auto& sink : m_sinkDeliveries)
+        {
+            std::cout << "Sink " << GetNodeAddressFromId(sink.first) << ": " << sink.second
+                      << " packets (" << (sum > 0 ? sink.second / sum * 100 : 0) << "%)"
+                      << std::endl;
+        }
+        std::cout << "Sink load balance (Jain): "
+                  << (squares > 0 ? sum * sum / (m_sinkDeliveries.size() * squares) : 1)
+                  << std::endl;
+    }
+}
+
+void
+LraExample::SampleAllocations(size_t slot)
+{
+    m_trafficAllocations[slot] = {LraGetAllocationCounts(), m_ipTransmissions};
+}
 
-    std::cout << "Total packets:" << tot_acnt << ", Total packets lost: " << total_loss
-              << ", Loss(%): " << ((double)total_loss / tot_acnt) * 100.0 << std::endl;
+void
+LraExample::SampleMemory(const std::string& phase)
+{
+    if (memoryReport)
+    {
+        m_memoryPhases.emplace_back(phase, GetResidentBytes());
+    }
 }
 
 void
@@ -280,7 +1378,9 @@ LraExample::CreateNodes()
 {
     uint32_t tot_nodes = size;
     uint32_t rectSize = step;
-    std::cout << "Creating " << (unsigned)tot_nodes << " nodes in a " << rectSize * rectSize
+    double width = step;
+    double height = areaHeight > 0 ? areaHeight : step;
+    std::cout << "Creating " << (unsigned)tot_nodes << " nodes in a " << width * height
               << " m^2 area.\n";
     nodes.Create(tot_nodes);
 
@@ -293,10 +1393,17 @@ LraExample::CreateNodes()
     }
 
     MobilityHelper mobility;
-    mobility.SetPositionAllocator(
-        "ns3::RandomRectanglePositionAllocator",
-        "X", StringValue("ns3::UniformRandomVariable[Min=0.0|Max=" + std::to_string(rectSize) + ".0]"),
-        "Y", StringValue("ns3::UniformRandomVariable[Min=0.0|Max="+ std::to_string(rectSize) + ".0]"));
+    if (scenarioFile.empty())
+    {
+        mobility.SetPositionAllocator(
+            "ns3::RandomRectanglePositionAllocator",
+            "X", StringValue("ns3::UniformRandomVariable[Min=0.0|Max=" + std::to_string(rectSize) + ".0]"),
+            "Y", StringValue("ns3::UniformRandomVariable[Min=0.0|Max="+ std::to_string(rectSize) + ".0]"));
+    }
+    else
+    {
+        mobility.SetPositionAllocator(GetScenarioPositions(width, height));
+    }
 
     mobility.SetMobilityModel("ns3::RandomWalk2dMobilityModel",
                               "Mode",
@@ -306,42 +1413,509 @@ LraExample::CreateNodes()
                               "Speed",
                               StringValue("ns3::UniformRandomVariable[Min=0.0|Max=0.0]"),
                               "Bounds",
-                              RectangleValue(Rectangle(0, rectSize, 0, rectSize)));
+                              RectangleValue(Rectangle(0, width, 0, height)));
     mobility.Install(nodes);
 
     // Set mobility random number streams to fixed values
     mobility.AssignStreams(nodes, 12345); // set randomness
-    AsciiTraceHelper ascii;
-    MobilityHelper::EnableAsciiAll(ascii.CreateFileStream("mobility-trace-lra.mob"));
-}
 
-void LraExample::OnInitializeComplete(){
-    // Set Nodes to move around
-    for (uint32_t i = 0; i < nodes.GetN(); ++i)
+    for (uint32_t i = 0; i < m_checkpoint.nodes.size(); ++i)
     {
-        Ptr<Node> node = nodes.Get(i);
-        // mean = 12, median = 8, min = 6, max = 80
-        node->GetObject<RandomWalk2dMobilityModel>()->SetAttribute(
-            "Speed",
-            StringValue("ns3::ParetoRandomVariable[Bound=80.0|Scale=6.0|Shape=2.0]"));
+        const LraCheckpointNodeRecord& record = m_checkpoint.nodes[i].record;
+        nodes.Get(i)->GetObject<MobilityModel>()->SetPosition(
+            Vector(record.x, record.y, record.z));
+    }
+    if (mobilityTrace)
+    {
+        AsciiTraceHelper ascii;
+        MobilityHelper::EnableAsciiAll(ascii.CreateFileStream("mobility-trace-lra.mob"));
     }
 }
 
-void
-LraExample::CreateDevices()
+Ptr<ListPositionAllocator>
+LraExample::GetScenarioPositions(double width, double height)
 {
-    WifiMacHelper wifiMac;
-    wifiMac.SetType("ns3::AdhocWifiMac");
-    YansWifiPhyHelper wifiPhy;
-    wifiPhy.Set("CcaEdThreshold", DoubleValue (0));
-    wifiPhy.Set("CcaSensitivity", DoubleValue (0));
-    YansWifiChannelHelper wifiChannel = YansWifiChannelHelper::Default();
-    wifiPhy.SetChannel(wifiChannel.Create());
-    WifiHelper wifi;
-    wifi.SetStandard(WIFI_STANDARD_80211ac);
-    wifi.SetRemoteStationManager("ns3::IdealWifiManager");
+    const std::string& placement = m_scenario.placement;
+    const std::vector<double>& parameters = m_scenario.placementParameters;
+    Ptr<UniformRandomVariable> uniform = CreateObject<UniformRandomVariable>();
+    uniform->SetStream(12344);
+
+    std::vector<Vector> centers;
+    if (placement == "cluster")
+    {
+        for (uint32_t c = 0; c < std::max(1.0, parameters[0]); ++c)
+        {
+            centers.emplace_back(uniform->GetValue(0, width), uniform->GetValue(0, height), 0);
+        }
+    }
+
+    Ptr<ListPositionAllocator> positions = CreateObject<ListPositionAllocator>();
+    for (uint32_t i = 0; i < size; ++i)
+    {
+        Vector position;
+        if (i < m_scenario.positions.size())
+        {
+            const LraScenarioPosition& given = m_scenario.positions[i];
+            position = Vector(given.x, given.y, given.z);
+        }
+        else if (placement == "grid")
+        {
+            uint32_t columns = std::max(1.0, parameters[0]);
+            uint32_t rows = (size + columns - 1) / columns;
+            position = Vector((i % columns + 0.5) * width / columns,
+                              (i / columns + 0.5) * height / rows,
+                              0);
+        }
+        else if (placement == "cluster")
+        {
+            // Uniform in a disc of the given radius around a random center
+            const Vector& center = centers[i % centers.size()];
+            double radius = parameters[1] * std::sqrt(uniform->GetValue());
+            double angle = uniform->GetValue(0, 2 * M_PI);
+            position = Vector(center.x + radius * std::cos(angle),
+                              center.y + radius * std::sin(angle),
+                              0);
+        }
+        else if (placement == "corridor")
+        {
+            double half = std::min(parameters[0], height) / 2;
+            position = Vector(uniform->GetValue(0, width),
+                              uniform->GetValue(height / 2 - half, height / 2 + half),
+                              0);
+        }
+        else
+        {
+            position = Vector(uniform->GetValue(0, width), uniform->GetValue(0, height), 0);
+        }
+        // The random walk needs every node inside its bounds
+        position.x = std::clamp(position.x, 0.0, width);
+        position.y = std::clamp(position.y, 0.0, height);
+        positions->Add(position);
+    }
+    return positions;
+}
+
+void LraExample::OnInitializeComplete(){
+    // Scenario mobility, by default Pareto speeds: mean = 12, median = 8, min = 6, max = 80
+    const std::vector<double>& parameters = m_scenario.mobilityParameters;
+    std::string speed = "ns3::ParetoRandomVariable[Bound=80.0|Scale=6.0|Shape=2.0]";
+    if (m_scenario.mobility == "static")
+    {
+        return;
+    }
+    else if (m_scenario.mobility == "walk")
+    {
+        speed = "ns3::UniformRandomVariable[Min=" + std::to_string(parameters[0]) +
+                "|Max=" + std::to_string(parameters[1]) + "]";
+    }
+    else if (m_scenario.mobility == "pareto")
+    {
+        speed = "ns3::ParetoRandomVariable[Bound=" + std::to_string(parameters[2]) +
+                "|Scale=" + std::to_string(parameters[0]) +
+                "|Shape=" + std::to_string(parameters[1]) + "]";
+    }
+
+    // Set Nodes to move around
+    for (uint32_t i = 0; i < nodes.GetN(); ++i)
+    {
+        Ptr<Node> node = nodes.Get(i);
+        node->GetObject<RandomWalk2dMobilityModel>()->SetAttribute("Speed", StringValue(speed));
+    }
+}
+
+void
+LraExample::SaveCheckpoint()
+{
+    LraCheckpoint checkpoint;
+    checkpoint.timeNs = Simulator::Now().GetNanoSeconds();
+    checkpoint.nodes.resize(nodes.GetN());
+    std::vector<LraDagEdge> edges;
+    for (uint32_t i = 0; i < nodes.GetN(); ++i)
+    {
+        LraCheckpointNode& state = checkpoint.nodes[i];
+        nodes.Get(i)->GetObject<LraRoutingProtocol>()->SaveState(state);
+        Vector position = nodes.Get(i)->GetObject<MobilityModel>()->GetPosition();
+        state.record.x = position.x;
+        state.record.y = position.y;
+        state.record.z = position.z;
+        for (const auto& link : state.links)
+        {
+            auto neighbor = m_nodeIndexByAddress.find(Ipv4Address(link.neighbor));
+            if (neighbor != m_nodeIndexByAddress.end())
+            {
+                edges.push_back(LraDagEdge{i, neighbor->second, link.state});
+            }
+        }
+    }
+
+    if (!checkpoint.Save(saveCheckpointFile))
+    {
+        std::cerr << "Error writing checkpoint " << saveCheckpointFile << std::endl;
+        return;
+    }
+    LraDagMetrics metrics = AnalyzeDag(nodes.GetN(), m_sinkIndices, edges);
+    std::cout << "Checkpoint written to " << saveCheckpointFile << " at "
+              << Simulator::Now().GetSeconds() << " s"
+              << (metrics.IsConverged() ? "" : " (warning: the DAG is not converged yet)") << "\n";
+}
+
+void
+LraExample::ScheduleFailures()
+{
+    m_isDown.assign(nodes.GetN(), false);
+    for (size_t i = 0; i < m_scenario.failures.size(); ++i)
+    {
+        Simulator::Schedule(Seconds(m_scenario.failures[i].time),
+                            &LraExample::InjectFailure,
+                            this,
+                            i);
+    }
+}
+
+void
+LraExample::InjectFailure(size_t index)
+{
+    const LraScenarioFailure& failure = m_scenario.failures[index];
+    if (failure.nodes.empty())
+    {
+        // Nodes inside the region now, they may have moved since the start
+        std::vector<uint32_t> inside = GetNodesInRegion(failure);
+        m_regionCut->Cut(failure.x0, failure.y0, failure.x1, failure.y1);
+        NotifyLostLinks([this](uint32_t i, uint32_t j) { return IsCutOff(i, j); });
+        std::cout << "Failure at " << Simulator::Now().GetSeconds() << " s: " << inside.size()
+                  << " nodes cut off\n";
+        OpenFailureRecord("region", inside, failure.downtime);
+        if (failure.downtime > 0)
+        {
+            Simulator::Schedule(Seconds(failure.downtime), &LraExample::HealRegion, this, index);
+        }
+        return;
+    }
+
+    // Nodes already down keep the restart time of their first failure
+    std::vector<uint32_t> failing = failure.nodes;
+    failing.erase(std::remove_if(failing.begin(),
+                                 failing.end(),
+                                 [this](uint32_t i) { return m_isDown[i]; }),
+                  failing.end());
+    std::sort(failing.begin(), failing.end());
+    failing.erase(std::unique(failing.begin(), failing.end()), failing.end());
+
+    // Interface 1 is the one LRA and the applications use
+    for (uint32_t i : failing)
+    {
+        m_isDown[i] = true;
+        nodes.Get(i)->GetObject<Ipv4>()->SetDown(1);
+    }
+    NotifyLostLinks([this](uint32_t, uint32_t j) { return m_isDown[j]; });
+    std::cout << "Failure at " << Simulator::Now().GetSeconds() << " s: " << failing.size()
+              << " nodes down\n";
+    OpenFailureRecord("crash", failing, failure.downtime);
+    if (failure.downtime > 0 && !failing.empty())
+    {
+        Simulator::Schedule(Seconds(failure.downtime), &LraExample::RestoreNodes, this, failing);
+    }
+}
+
+void
+LraExample::RestoreNodes(std::vector<uint32_t> restored)
+{
+    for (uint32_t i : restored)
+    {
+        m_isDown[i] = false;
+        nodes.Get(i)->GetObject<Ipv4>()->SetUp(1);
+    }
+    OpenFailureRecord("restart", restored, 0);
+}
+
+void
+LraExample::HealRegion(size_t index)
+{
+    const LraScenarioFailure& failure = m_scenario.failures[index];
+    std::vector<uint32_t> inside = GetNodesInRegion(failure);
+    std::vector<bool> isInside(nodes.GetN(), false);
+    for (uint32_t i : inside)
+    {
+        isInside[i] = true;
+    }
+    m_regionCut->Restore(failure.x0, failure.y0, failure.x1, failure.y1);
+
+    // One hello per pair in range across the border sets the link up on both sides
+    for (uint32_t i : inside)
+    {
+        if (m_isDown[i])
+        {
+            continue;
+        }
+        Ptr<MobilityModel> mobility = nodes.Get(i)->GetObject<MobilityModel>();
+        Ptr<LraRoutingProtocol> lraRouting = nodes.Get(i)->GetObject<LraRoutingProtocol>();
+        for (uint32_t j = 0; j < nodes.GetN(); ++j)
+        {
+            if (isInside[j] || m_isDown[j] || IsCutOff(i, j) ||
+                mobility->GetDistanceFrom(nodes.Get(j)->GetObject<MobilityModel>()) >
+                    m_radioRange)
+            {
+                continue;
+            }
+            lraRouting->NotifyNeighborFound(GetNodeAddressFromId(j));
+        }
+    }
+    std::cout << "Region healed at " << Simulator::Now().GetSeconds() << " s\n";
+    OpenFailureRecord("heal", inside, 0);
+}
+
+std::vector<uint32_t>
+LraExample::GetNodesInRegion(const LraScenarioFailure& failure) const
+{
+    std::vector<uint32_t> inside;
+    for (uint32_t i = 0; i < nodes.GetN(); ++i)
+    {
+        Vector position = nodes.Get(i)->GetObject<MobilityModel>()->GetPosition();
+        if (position.x >= failure.x0 && position.x <= failure.x1 && position.y >= failure.y0 &&
+            position.y <= failure.y1)
+        {
+            inside.push_back(i);
+        }
+    }
+    return inside;
+}
+
+bool
+LraExample::IsCutOff(uint32_t i, uint32_t j) const
+{
+    return m_regionCut &&
+           m_regionCut->IsCut(nodes.Get(i)->GetObject<MobilityModel>()->GetPosition(),
+                              nodes.Get(j)->GetObject<MobilityModel>()->GetPosition());
+}
+
+void
+LraExample::NotifyLostLinks(const std::function<bool(uint32_t, uint32_t)>& lost)
+{
+    for (uint32_t i = 0; i < nodes.GetN(); ++i)
+    {
+        if (m_isDown[i])
+        {
+            continue;
+        }
+        Ptr<LraRoutingProtocol> lraRouting = nodes.Get(i)->GetObject<LraRoutingProtocol>();
+        for (const auto& link : lraRouting->GetLinkStates())
+        {
+            auto neighbor = m_nodeIndexByAddress.find(link.first);
+            if (neighbor != m_nodeIndexByAddress.end() && lost(i, neighbor->second))
+            {
+                lraRouting->NotifyNeighborLost(link.first);
+            }
+        }
+    }
+}
+
+void
+LraExample::OpenFailureRecord(const std::string& kind,
+                              const std::vector<uint32_t>& affected,
+                              double downtime)
+{
+    FailureRecord record;
+    record.time = Simulator::Now().GetSeconds();
+    record.kind = kind;
+    record.nodes = affected;
+    // Echo runs end when the event queue drains: a failure the network never recovers from,
+    // such as a crashed sink, must not keep the probes going
+    record.deadline = GetTrafficEnd();
+    if (downtime > 0)
+    {
+        record.deadline = std::min(record.deadline, record.time + downtime);
+    }
+    record.reversalsAtStart = GetTotalReversals();
+    m_failureRecords.push_back(record);
+    if (!m_failureProbe.IsPending())
+    {
+        m_failureProbe = Simulator::ScheduleNow(&LraExample::ProbeReconvergence, this);
+    }
+}
+
+void
+LraExample::ProbeReconvergence()
+{
+    std::vector<LraDagEdge> edges;
+    uint32_t stale = 0;
+    for (uint32_t i = 0; i < nodes.GetN(); ++i)
+    {
+        if (m_isDown[i])
+        {
+            continue;
+        }
+        Ptr<LraRoutingProtocol> lraRouting = nodes.Get(i)->GetObject<LraRoutingProtocol>();
+        for (const auto& link : lraRouting->GetLinkStates())
+        {
+            auto neighbor = m_nodeIndexByAddress.find(link.first);
+            if (neighbor == m_nodeIndexByAddress.end())
+            {
+                continue;
+            }
+            if (m_isDown[neighbor->second] || IsCutOff(i, neighbor->second))
+            {
+                // The node may still forward through it
+                stale += link.second != 0;
+                continue;
+            }
+            edges.push_back(LraDagEdge{i, neighbor->second, link.second});
+        }
+    }
+    std::vector<uint32_t> sinks;
+    for (uint32_t sink : m_sinkIndices)
+    {
+        if (!m_isDown[sink])
+        {
+            sinks.push_back(sink);
+        }
+    }
+    bool converged = stale == 0 && AnalyzeDag(nodes.GetN(), sinks, edges).IsConverged();
+
+    uint64_t reversals = GetTotalReversals();
+    double now = Simulator::Now().GetSeconds();
+    bool pending = false;
+    for (auto& record : m_failureRecords)
+    {
+        if (record.closed)
+        {
+            continue;
+        }
+        // Until a restarted node has links, the analysis sees it as isolated, not unrouted
+        bool attached = std::all_of(record.nodes.begin(), record.nodes.end(), [&](uint32_t i) {
+            return record.kind != "restart" || m_isDown[i] ||
+                   !nodes.Get(i)->GetObject<LraRoutingProtocol>()->GetLinkStates().empty();
+        });
+        if (converged && attached)
+        {
+            record.reconvergedAt = now;
+        }
+        else if (now < record.deadline)
+        {
+            pending = true;
+            continue;
+        }
+        record.closed = true;
+        record.reversals = reversals - record.reversalsAtStart;
+    }
+    if (pending)
+    {
+        m_failureProbe =
+            Simulator::Schedule(MilliSeconds(100), &LraExample::ProbeReconvergence, this);
+    }
+}
+
+uint64_t
+LraExample::GetTotalReversals() const
+{
+    uint64_t reversals = 0;
+    for (uint32_t i = 0; i < nodes.GetN(); ++i)
+    {
+        reversals += nodes.Get(i)->GetObject<LraRoutingProtocol>()->GetReversals();
+    }
+    return reversals;
+}
+
+void
+LraExample::CreateDevices()
+{
+    if (std::any_of(m_scenario.failures.begin(),
+                    m_scenario.failures.end(),
+                    [](const LraScenarioFailure& failure) { return failure.nodes.empty(); }))
+    {
+        m_regionCut = CreateObject<LraRegionCutLossModel>();
+    }
+    if (channelType == "unitdisk")
+    {
+        CreateUnitDiskDevices();
+    }
+    else
+    {
+        CreateWifiDevices();
+    }
+}
+
+void
+LraExample::CreateUnitDiskDevices()
+{
+    Ptr<LraUnitDiskChannel> channel = CreateObject<LraUnitDiskChannel>();
+    channel->SetAttribute("Range", DoubleValue(range));
+    channel->SetAttribute("LinkDelay", TimeValue(Seconds(linkDelay / 1000.0)));
+    channel->SetAttribute("LossProbability", DoubleValue(lossProbability));
+    channel->AssignStreams(12345);
+    if (m_regionCut)
+    {
+        channel->SetRegionCut(m_regionCut);
+    }
+
+    SimpleNetDeviceHelper simple;
+    netDevices = simple.Install(nodes, channel);
+    m_radioRange = range;
+
+    if (pcap)
+    {
+        std::cout << "PCAP traces are not available on the unit disk channel.\n";
+    }
+}
+
+void
+LraExample::CreateWifiDevices()
+{
+    WifiMacHelper wifiMac;
+    wifiMac.SetType("ns3::AdhocWifiMac");
+    WifiHelper wifi;
+    wifi.SetStandard(WIFI_STANDARD_80211ac);
+    wifi.SetRemoteStationManager("ns3::IdealWifiManager");
+
+    if (channelType == "gridwifi")
+    {
+        // Same propagation as YansWifiChannelHelper::Default(), cut where YANS drops the
+        // signal anyway: 16.0206 dBm default TX power against -101 dBm RX sensitivity.
+        Ptr<LraGridSpectrumChannel> channel = CreateObject<LraGridSpectrumChannel>();
+        channel->AddPropagationLossModel(CreateObject<LogDistancePropagationLossModel>());
+        if (m_regionCut)
+        {
+            channel->AddPropagationLossModel(m_regionCut);
+        }
+        channel->SetPropagationDelayModel(CreateObject<ConstantSpeedPropagationDelayModel>());
+        channel->SetAttribute("MaxLossDb", DoubleValue(16.0206 + 101.0));
+
+        SpectrumWifiPhyHelper wifiPhy;
+        wifiPhy.Set("CcaEdThreshold", DoubleValue (0));
+        wifiPhy.Set("CcaSensitivity", DoubleValue (0));
+        wifiPhy.SetChannel(channel);
+        netDevices = wifi.Install(wifiPhy, wifiMac, nodes);
+        m_radioRange = channel->GetRange();
+        std::cout << "Grid channel range: " << m_radioRange << " m\n";
+
+        if (pcap)
+        {
+            wifiPhy.EnablePcapAll(std::string("lra"));
+        }
+        return;
+    }
+
+    YansWifiPhyHelper wifiPhy;
+    wifiPhy.Set("CcaEdThreshold", DoubleValue (0));
+    wifiPhy.Set("CcaSensitivity", DoubleValue (0));
+    YansWifiChannelHelper wifiChannel = YansWifiChannelHelper::Default();
+    Ptr<YansWifiChannel> channel = DynamicCast<YansWifiChannel>(wifiChannel.Create());
+    if (m_regionCut)
+    {
+        // The helper's default path loss, followed by the cut
+        Ptr<LogDistancePropagationLossModel> pathLoss =
+            CreateObject<LogDistancePropagationLossModel>();
+        pathLoss->SetNext(m_regionCut);
+        channel->SetPropagationLossModel(pathLoss);
+    }
+    wifiPhy.SetChannel(channel);
     netDevices = wifi.Install(wifiPhy, wifiMac, nodes);
 
+    // YANS does not expose a range, derive it like the grid channel does from the same model
+    Ptr<LraGridSpectrumChannel> reference = CreateObject<LraGridSpectrumChannel>();
+    reference->AddPropagationLossModel(CreateObject<LogDistancePropagationLossModel>());
+    reference->SetAttribute("MaxLossDb", DoubleValue(16.0206 + 101.0));
+    m_radioRange = reference->GetRange();
+
     if (pcap)
     {
         wifiPhy.EnablePcapAll(std::string("lra"));
@@ -352,43 +1926,283 @@ void
 LraExample::InstallInternetStack()
 {
     LraHelper lra;
+    // Link lifetimes are predicted against the range of the channel in use
+    lra.Set("LinkRange", DoubleValue(m_radioRange));
+    AodvHelper aodv;
+    OlsrHelper olsr;
+    DsdvHelper dsdv;
     InternetStackHelper stack;
 
-    stack.SetRoutingHelper(lra);
-    stack.Install(nodes);
+    // Same streams for every protocol, so only the routing differs between runs
+    if (routing == "aodv")
+    {
+        stack.SetRoutingHelper(aodv);
+        stack.Install(nodes);
+        aodv.AssignStreams(nodes, 1000000);
+    }
+    else if (routing == "olsr")
+    {
+        stack.SetRoutingHelper(olsr);
+        stack.Install(nodes);
+        olsr.AssignStreams(nodes, 1000000);
+    }
+    else if (routing == "dsdv")
+    {
+        stack.SetRoutingHelper(dsdv);
+        stack.Install(nodes);
+    }
+    else
+    {
+        stack.SetRoutingHelper(lra);
+        stack.Install(nodes);
+        lra.AssignStreams(nodes, 1000000);
+    }
+    m_startJitter->SetStream(2000000);
 
+    // Replications share the process, free the addresses of the previous one
+    Ipv4AddressGenerator::Reset();
     Ipv4AddressHelper address;
     address.SetBase("10.0.0.0", "255.0.0.0");
     ipv4Interfaces = address.Assign(netDevices);
-    m_sinkAddress = ipv4Interfaces.GetAddress(nodes.GetN() - 1);
+    m_sinkAddress = ipv4Interfaces.GetAddress(m_sinkIndex);
+    m_sinkAddresses.clear();
+    for (uint32_t sink : m_sinkIndices)
+    {
+        m_sinkAddresses.push_back(ipv4Interfaces.GetAddress(sink));
+    }
+    // The anycast address goes first
+    std::iter_swap(m_sinkAddresses.begin(),
+                   std::find(m_sinkAddresses.begin(), m_sinkAddresses.end(), m_sinkAddress));
+    for (uint32_t i = 0; i < nodes.GetN(); ++i)
+    {
+        m_nodeIndexByAddress[GetNodeAddressFromId(i)] = i;
+    }
 
     InitNodesRouting();
 
+    // Measured below the routing protocol, so every protocol is measured the same way
+    for (uint32_t index : m_sinkIndices)
+    {
+        std::ostringstream sink;
+        sink << "/NodeList/" << nodes.Get(index)->GetId() << "/$ns3::Ipv4L3Protocol/LocalDeliver";
+        Config::Connect(sink.str(), MakeCallback(&LraExample::TraceSinkDelivery, this));
+    }
+    Config::Connect("/NodeList/*/$ns3::Ipv4L3Protocol/Tx",
+                    MakeCallback(&LraExample::TraceIpTx, this));
+
     if (printRoutes)
     {
         Ptr<OutputStreamWrapper> routingStream =
-            Create<OutputStreamWrapper>("lra.routes", std::ios::out);
-        LraHelper::PrintRoutingTableAllAt(Seconds(startDelay-1), routingStream);
+            Create<OutputStreamWrapper>(routing + ".routes", std::ios::out);
+        Ipv4RoutingHelper::PrintRoutingTableAllAt(Seconds(startDelay-1), routingStream);
     }
 }
 
 void
 LraExample::InitNodesRouting()
 {    
+    std::vector<std::vector<uint32_t>> neighbors;
+    if (oracle || warmStart)
+    {
+        neighbors = GetOracleNeighbors();
+        ComputeOracle(neighbors);
+    }
+    if (!IsLra())
+    {
+        return;
+    }
+
     // Initialize LRA routing protocol for each node
     for (uint32_t i = 0; i < nodes.GetN(); ++i)
     {
         Ptr<Node> node = nodes.Get(i);
         Ptr<LraRoutingProtocol> lraRouting = node->GetObject<LraRoutingProtocol>();
-        lraRouting->InitializeNode(m_sinkAddress, i);
+        if (!m_checkpoint.nodes.empty())
+        {
+            NS_ABORT_MSG_IF(m_checkpoint.nodes[i].record.address != GetNodeAddressFromId(i).Get(),
+                            "Checkpoint address numbering does not match node " << i);
+            lraRouting->RestoreState(m_sinkAddresses, i, m_checkpoint.nodes[i]);
+        }
+        else if (warmStart)
+        {
+            lraRouting->WarmStart(m_sinkAddresses, i, GetOracleLinks(i, neighbors));
+        }
+        else
+        {
+            lraRouting->InitializeNode(m_sinkAddresses, i);
+        }
     }
 }
 
+std::vector<std::vector<uint32_t>>
+LraExample::GetOracleNeighbors()
+{
+    uint32_t n = nodes.GetN();
+    if (m_oracleDepth.empty())
+    {
+        // Registered once, the grid then follows the nodes through their course changes
+        m_oracleGrid.SetCellSize(m_radioRange, m_radioRange / 4);
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            m_oracleGrid.Add(i, nodes.Get(i)->GetObject<MobilityModel>());
+        }
+    }
+
+    std::vector<std::vector<uint32_t>> neighbors(n);
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        Ptr<MobilityModel> mobility = nodes.Get(i)->GetObject<MobilityModel>();
+        m_oracleGrid.ForEachCandidate(mobility->GetPosition(), m_radioRange, [&](uint32_t j) {
+            if (j != i &&
+                mobility->GetDistanceFrom(nodes.Get(j)->GetObject<MobilityModel>()) <= m_radioRange)
+            {
+                neighbors[i].push_back(j);
+            }
+        });
+    }
+    return neighbors;
+}
+
+void
+LraExample::ComputeOracle(const std::vector<std::vector<uint32_t>>& neighbors)
+{
+    // Every sink seeds the search, so each node gets the depth of its nearest sink
+    m_oracleDepth.assign(nodes.GetN(), UINT32_MAX);
+    std::vector<uint32_t> queue = m_sinkIndices;
+    for (uint32_t sink : m_sinkIndices)
+    {
+        m_oracleDepth[sink] = 0;
+    }
+    for (size_t head = 0; head < queue.size(); ++head)
+    {
+        uint32_t v = queue[head];
+        for (uint32_t w : neighbors[v])
+        {
+            if (m_oracleDepth[w] == UINT32_MAX)
+            {
+                m_oracleDepth[w] = m_oracleDepth[v] + 1;
+                queue.push_back(w);
+            }
+        }
+    }
+}
+
+std::vector<std::pair<Ipv4Address, int>>
+LraExample::GetOracleLinks(uint32_t i, const std::vector<std::vector<uint32_t>>& neighbors)
+{
+    // Toward the neighbor closer to a sink, ties broken toward the higher address like
+    // the hello exchange does. Both ends agree and the order is total, so the result is a DAG.
+    std::vector<std::pair<Ipv4Address, int>> links;
+    Ipv4Address address = GetNodeAddressFromId(i);
+    for (uint32_t j : neighbors[i])
+    {
+        Ipv4Address neighbor = GetNodeAddressFromId(j);
+        bool outgoing = m_oracleDepth[j] < m_oracleDepth[i] ||
+                        (m_oracleDepth[j] == m_oracleDepth[i] && address < neighbor);
+        links.emplace_back(neighbor, outgoing ? 1 : 0);
+    }
+    return links;
+}
+
+double
+LraExample::GetOracleAverageHopCount() const
+{
+    // Same metric as LraRoutingProtocol::GetAverageHopCount: TTL decrements, i.e. forwarders
+    uint64_t sum = 0;
+    uint32_t reachable = 0;
+    for (uint32_t depth : m_oracleDepth)
+    {
+        if (depth != UINT32_MAX && depth > 0)
+        {
+            sum += depth - 1;
+            reachable++;
+        }
+    }
+    return reachable > 0 ? double(sum) / reachable : 0;
+}
+
 void
 LraExample::InstallApplications()
+{
+    if (trafficModel == "echo")
+    {
+        InstallEchoApplications();
+    }
+    else
+    {
+        InstallTrafficApplications();
+    }
+}
+
+void
+LraExample::InstallTrafficApplications()
+{
+    const uint16_t port = 10;
+    m_dataPort = port;
+    PacketSinkHelper sinkHelper("ns3::UdpSocketFactory",
+                                InetSocketAddress(Ipv4Address::GetAny(), port));
+    ApplicationContainer sinkApps;
+    for (uint32_t sink : m_sinkIndices)
+    {
+        sinkApps.Add(sinkHelper.Install(nodes.Get(sink)));
+    }
+    sinkApps.Start(Seconds(0));
+    sinkApps.Stop(Seconds(totalTime));
+
+    std::map<std::string, std::string> models = {{"cbr", "Cbr"},
+                                                 {"poisson", "Poisson"},
+                                                 {"onoff", "OnOff"},
+                                                 {"trace", "Trace"}};
+    ObjectFactory factory("ns3::LraTrafficSource");
+    factory.Set("Remote", AddressValue(InetSocketAddress(m_sinkAddress, port)));
+    factory.Set("Model", StringValue(models[trafficModel]));
+    factory.Set("PacketSize", UintegerValue(packetSize));
+    factory.Set("DataRate", StringValue(trafficRate));
+    factory.Set("RampStep", StringValue(rampStep));
+    factory.Set("RampInterval", TimeValue(Seconds(rampInterval)));
+    factory.Set("OnTime",
+                StringValue("ns3::ExponentialRandomVariable[Mean=" + std::to_string(onTime) + "]"));
+    factory.Set("OffTime",
+                StringValue("ns3::ExponentialRandomVariable[Mean=" + std::to_string(offTime) +
+                            "]"));
+    factory.Set("TraceFile", StringValue(trafficTraceFile));
+
+    Time jitter = Time(Seconds(startDelay));
+    Simulator::Schedule(jitter, &PrintCheckpoint);
+    for (uint32_t i = 0; i < nodes.GetN(); ++i)
+    {
+        if (!m_isSource[i])
+        {
+            continue;
+        }
+        Ptr<LraTrafficSource> source = factory.Create<LraTrafficSource>();
+        nodes.Get(i)->AddApplication(source);
+        source->AssignStreams(100 + 3 * i);
+        // Sub-second jitter: sources must overlap for the load to add up
+        source->SetStartTime(Seconds(startDelay) +
+                             MilliSeconds(m_startJitter->GetInteger(0, 999)));
+        source->SetStopTime(Seconds(startDelay + trafficTime));
+    }
+
+    Config::Connect("/NodeList/*/ApplicationList/*/$ns3::LraTrafficSource/Tx",
+                    MakeCallback(&LraExample::LogTrafficSend, this));
+    Config::Connect("/NodeList/*/ApplicationList/*/$ns3::PacketSink/Rx",
+                    MakeCallback(&LraExample::LogTrafficReceive, this));
+}
+
+size_t
+LraExample::GetTrafficWindow() const
+{
+    double elapsed = std::max(0.0, Simulator::Now().GetSeconds() - startDelay);
+    return rampInterval > 0 ? static_cast<size_t>(elapsed / rampInterval) : 0;
+}
+
+void
+LraExample::InstallEchoApplications()
 {
     // Set each node to be both echo client and server
     int port = 9;
+    m_dataPort = port;
     UdpEchoServerHelper echoServer(port);
     ApplicationContainer echoServerApps = echoServer.Install(nodes);
     echoServerApps.Start(Seconds(0));
@@ -401,10 +2215,14 @@ LraExample::InstallApplications()
 
     Time jitter = Time(Seconds(startDelay));
     Simulator::Schedule(jitter, &PrintCheckpoint);
-    for (uint32_t i = 0; i < nodes.GetN() - 1; ++i)
+    for (uint32_t i = 0; i < nodes.GetN(); ++i)
     {
+        if (!m_isSource[i])
+        {
+            continue;
+        }
         auto app = echoClient.Install(nodes.Get(i));
-        int randa = rand() % 1000;
+        int randa = m_startJitter->GetInteger(0, 999);
         app.Start(Seconds(startDelay + randa)); // needed to avoid collisions
         app.Stop(Seconds(totalTime) - Seconds(0.001));
     }
@@ -416,6 +2234,278 @@ LraExample::InstallApplications()
                     MakeCallback(&LraExample::LogMessageSend, this));
 }
 
+void
+LraExample::InstallEnergyModels()
+{
+    if (channelType == "unitdisk")
+    {
+        std::cout << "Energy models need a Wi-Fi channel, ignored on the unit disk channel.\n";
+        return;
+    }
+
+    BasicEnergySourceHelper sourceHelper;
+    sourceHelper.Set("BasicEnergySourceInitialEnergyJ", DoubleValue(initialEnergy));
+    m_energySources = sourceHelper.Install(nodes);
+    WifiRadioEnergyModelHelper radioHelper;
+    m_radioEnergyModels = radioHelper.Install(netDevices, m_energySources);
+    m_energyAccounts.assign(nodes.GetN(), EnergyAccount());
+
+    for (uint32_t i = 0; i < nodes.GetN(); ++i)
+    {
+        Ptr<EnergySource> source = m_energySources.Get(i);
+        if (IsLra())
+        {
+            nodes.Get(i)->GetObject<LraRoutingProtocol>()->SetEnergyLevelCallback(
+                MakeCallback(&EnergySource::GetEnergyFraction, source));
+        }
+
+        std::ostringstream ctx;
+        ctx << "/NodeList/" << i << "/EnergySource";
+        source->TraceConnect("RemainingEnergy",
+                             ctx.str(),
+                             MakeCallback(&LraExample::TraceRemainingEnergy, this));
+    }
+
+    Config::Connect("/NodeList/*/DeviceList/*/$ns3::WifiNetDevice/Phy/PhyTxPsduBegin",
+                    MakeCallback(&LraExample::TracePsduTxBegin, this));
+    Config::Connect("/NodeList/*/DeviceList/*/$ns3::WifiNetDevice/Phy/PhyTxEnd",
+                    MakeCallback(&LraExample::TracePhyTxEnd, this));
+}
+
+void
+LraExample::TracePsduTxBegin(std::string ctx,
+                             WifiConstPsduMap psdus,
+                             WifiTxVector txVector,
+                             double txPowerW)
+{
+    uint32_t node = GetNodeIdFromContext(ctx);
+    EnergyAccount& account = m_energyAccounts[node];
+    account.txStartEnergy = m_radioEnergyModels.Get(node)->GetTotalEnergyConsumption();
+
+    // Split the transmission by bytes, an A-MPDU may mix control and data
+    uint64_t controlBytes = 0;
+    uint64_t dataBytes = 0;
+    uint64_t totalBytes = 0;
+    for (const auto& psdu : psdus)
+    {
+        for (const auto& mpdu : *psdu.second)
+        {
+            uint32_t size = mpdu->GetSize();
+            totalBytes += size;
+            if (!mpdu->GetHeader().IsData())
+                continue;
+            Ptr<Packet> msdu = mpdu->GetPacket()->Copy();
+            LlcSnapHeader llc;
+            Ipv4Header ip;
+            if (msdu->RemoveHeader(llc) && llc.GetType() == Ipv4L3Protocol::PROT_NUMBER &&
+                msdu->RemoveHeader(ip) && IsRoutingControl(ip, msdu))
+            {
+                controlBytes += size;
+            }
+            else
+            {
+                dataBytes += size;
+            }
+        }
+    }
+    account.controlShare = totalBytes > 0 ? double(controlBytes) / totalBytes : 0;
+    account.dataShare = totalBytes > 0 ? double(dataBytes) / totalBytes : 0;
+}
+
+void
+LraExample::TracePhyTxEnd(std::string ctx, Ptr<const Packet> packet)
+{
+    uint32_t node = GetNodeIdFromContext(ctx);
+    EnergyAccount& account = m_energyAccounts[node];
+    double spent =
+        m_radioEnergyModels.Get(node)->GetTotalEnergyConsumption() - account.txStartEnergy;
+    account.controlJ += spent * account.controlShare;
+    account.dataJ += spent * account.dataShare;
+    account.macJ += spent * (1 - account.controlShare - account.dataShare);
+}
+
+void
+LraExample::TraceRemainingEnergy(std::string ctx, double oldValue, double newValue)
+{
+    // BasicEnergySource stops the node at its low battery threshold, 10% by default
+    if (m_firstDeath.IsNegative() && newValue <= initialEnergy * 0.1)
+    {
+        m_firstDeath = Simulator::Now();
+        std::cout << "Node " << GetNodeIdFromContext(ctx) << " ran out of energy at "
+                  << m_firstDeath.GetSeconds() << " s\n";
+    }
+}
+
+void
+LraExample::EnableDagSnapshots()
+{
+    std::vector<uint32_t> addresses;
+    for (uint32_t i = 0; i < nodes.GetN(); ++i)
+    {
+        addresses.push_back(GetNodeAddressFromId(i).Get());
+    }
+    if (!m_dagWriter.Open(dagFile, addresses, m_sinkIndices))
+    {
+        std::cerr << "Error opening " << dagFile << ", DAG snapshots disabled." << std::endl;
+        return;
+    }
+    Simulator::Schedule(Seconds(dagInterval), &LraExample::TakeDagSnapshot, this);
+}
+
+void
+LraExample::TakeDagSnapshot()
+{
+    LraDagSnapshot snapshot;
+    snapshot.timeNs = Simulator::Now().GetNanoSeconds();
+    for (uint32_t i = 0; i < nodes.GetN(); ++i)
+    {
+        Ptr<LraRoutingProtocol> lraRouting = nodes.Get(i)->GetObject<LraRoutingProtocol>();
+        for (const auto& link : lraRouting->GetLinkStates())
+        {
+            auto neighbor = m_nodeIndexByAddress.find(link.first);
+            if (neighbor != m_nodeIndexByAddress.end())
+            {
+                snapshot.edges.push_back(LraDagEdge{i, neighbor->second, link.second});
+            }
+        }
+    }
+    m_dagWriter.Write(snapshot);
+
+    // Echo runs end when the event queue drains, so the captures must stop by themselves
+    if (Simulator::Now() + Seconds(dagInterval) <= Seconds(GetTrafficEnd()))
+    {
+        Simulator::Schedule(Seconds(dagInterval), &LraExample::TakeDagSnapshot, this);
+    }
+}
+
+void
+LraExample::EnableBinaryTrace()
+{
+    if (!m_traceWriter.Open(binaryTraceFile))
+    {
+        std::cerr << "Error opening " << binaryTraceFile << ", binary trace disabled." << std::endl;
+        return;
+    }
+
+    // Initial positions, later ones come from course changes
+    for (uint32_t i = 0; i < nodes.GetN(); ++i)
+    {
+        std::ostringstream ctx;
+        ctx << "/NodeList/" << i << "/$ns3::MobilityModel/CourseChange";
+        TraceCourseChange(ctx.str(), nodes.Get(i)->GetObject<MobilityModel>());
+    }
+
+    Config::Connect("/NodeList/*/$ns3::MobilityModel/CourseChange",
+                    MakeCallback(&LraExample::TraceCourseChange, this));
+    Config::Connect("/NodeList/*/$ns3::LraRoutingProtocol/LinkStateChange",
+                    MakeCallback(&LraExample::TraceLinkState, this));
+    Config::Connect("/NodeList/*/$ns3::LraRoutingProtocol/Reversal",
+                    MakeCallback(&LraExample::TraceReversal, this));
+    Config::Connect("/NodeList/*/$ns3::LraRoutingProtocol/Forward",
+                    MakeCallback(&LraExample::TraceForward, this));
+    Config::Connect("/NodeList/*/$ns3::LraRoutingProtocol/Drop",
+                    MakeCallback(&LraExample::TraceDrop, this));
+    Config::Connect("/NodeList/*/$ns3::LraRoutingProtocol/LoopDetected",
+                    MakeCallback(&LraExample::TraceLoop, this));
+    Config::Connect("/NodeList/*/$ns3::LraRoutingProtocol/Partition",
+                    MakeCallback(&LraExample::TracePartition, this));
+    Config::Connect("/NodeList/*/$ns3::LraRoutingProtocol/Rejoin",
+                    MakeCallback(&LraExample::TraceRejoin, this));
+}
+
+LraTraceRecord
+LraExample::MakeTraceRecord(std::string ctx, LraTraceEventType type)
+{
+    LraTraceRecord record{};
+    record.timeNs = Simulator::Now().GetNanoSeconds();
+    record.node = GetNodeIdFromContext(ctx);
+    record.type = type;
+    return record;
+}
+
+void
+LraExample::TraceCourseChange(std::string ctx, Ptr<const MobilityModel> mobility)
+{
+    LraTraceRecord record = MakeTraceRecord(ctx, LRA_TRACE_COURSE_CHANGE);
+    Vector position = mobility->GetPosition();
+    Vector velocity = mobility->GetVelocity();
+    record.f[0] = position.x;
+    record.f[1] = position.y;
+    record.f[2] = velocity.x;
+    record.f[3] = velocity.y;
+    m_traceWriter.Write(record);
+}
+
+void
+LraExample::TraceLinkState(std::string ctx, Ipv4Address neighbor, int oldState, int newState)
+{
+    LraTraceRecord record = MakeTraceRecord(ctx, LRA_TRACE_LINK_STATE);
+    record.u[0] = neighbor.Get();
+    record.i[1] = oldState;
+    record.i[2] = newState;
+    m_traceWriter.Write(record);
+}
+
+void
+LraExample::TraceReversal(std::string ctx, uint32_t reversedLinks)
+{
+    LraTraceRecord record = MakeTraceRecord(ctx, LRA_TRACE_REVERSAL);
+    record.u[0] = reversedLinks;
+    m_traceWriter.Write(record);
+}
+
+void
+LraExample::TraceForward(std::string ctx,
+                         Ptr<const Packet> packet,
+                         const Ipv4Header& header,
+                         Ipv4Address nextHop)
+{
+    LraTraceRecord record = MakeTraceRecord(ctx, LRA_TRACE_FORWARD);
+    record.u[0] = packet->GetUid();
+    record.u[1] = nextHop.Get();
+    record.u[2] = header.GetSource().Get();
+    record.u[3] = header.GetDestination().Get();
+    m_traceWriter.Write(record);
+}
+
+void
+LraExample::TraceDrop(std::string ctx,
+                      Ptr<const Packet> packet,
+                      const Ipv4Header& header,
+                      LraDropReason reason)
+{
+    LraTraceRecord record = MakeTraceRecord(ctx, LRA_TRACE_DROP);
+    record.u[0] = packet->GetUid();
+    record.u[1] = reason;
+    record.u[2] = header.GetSource().Get();
+    record.u[3] = header.GetDestination().Get();
+    m_traceWriter.Write(record);
+}
+
+void
+LraExample::TraceLoop(std::string ctx, Ipv4Address suspect)
+{
+    LraTraceRecord record = MakeTraceRecord(ctx, LRA_TRACE_LOOP);
+    record.u[0] = suspect.Get();
+    m_traceWriter.Write(record);
+}
+
+void
+LraExample::TracePartition(std::string ctx, Ipv4Address origin)
+{
+    LraTraceRecord record = MakeTraceRecord(ctx, LRA_TRACE_PARTITION);
+    record.u[0] = origin.Get();
+    m_traceWriter.Write(record);
+}
+
+void
+LraExample::TraceRejoin(std::string ctx, Ipv4Address neighbor)
+{
+    LraTraceRecord record = MakeTraceRecord(ctx, LRA_TRACE_REJOIN);
+    record.u[0] = neighbor.Get();
+    m_traceWriter.Write(record);
+}
+
 void
 LraExample::LogMessageResponse(std::string ctx,
                                Ptr<const Packet> packet,
@@ -444,6 +2534,124 @@ LraExample::LogMessageSend(std::string ctx,
     tot_acnt++;
 }
 
+void
+LraExample::LogTrafficSend(std::string ctx, Ptr<const Packet> packet)
+{
+    auto nodeAddress = GetNodeAddressFromId(GetNodeIdFromContext(ctx));
+    m_packetsSentByNodes[nodeAddress]++;
+    tot_acnt++;
+
+    m_traffic.offeredBytes += packet->GetSize();
+    size_t window = GetTrafficWindow();
+    if (m_traffic.offeredByWindow.size() <= window)
+    {
+        m_traffic.offeredByWindow.resize(window + 1, 0);
+    }
+    m_traffic.offeredByWindow[window] += packet->GetSize();
+
+    // Packets sent before the network recovered are charged to the failure
+    SeqTsHeader seqTs;
+    packet->PeekHeader(seqTs);
+    for (auto& record : m_failureRecords)
+    {
+        if (record.reconvergedAt < 0)
+        {
+            record.sent.emplace_back(nodeAddress, seqTs.GetSeq());
+        }
+    }
+}
+
+void
+LraExample::LogTrafficReceive(std::string ctx, Ptr<const Packet> packet, const Address& from)
+{
+    // Throughput counts what crossed the network, UDP and IP headers included
+    uint32_t ipBytes = packet->GetSize() + 8 + 20;
+    m_traffic.deliveredBytes += ipBytes;
+    size_t window = GetTrafficWindow();
+    if (m_traffic.deliveredByWindow.size() <= window)
+    {
+        m_traffic.deliveredByWindow.resize(window + 1, 0);
+    }
+    m_traffic.deliveredByWindow[window] += ipBytes;
+
+    SeqTsHeader seqTs;
+    packet->PeekHeader(seqTs);
+    auto source = InetSocketAddress::ConvertFrom(from).GetIpv4();
+    if (!m_received[source].insert(seqTs.GetSeq()).second)
+    {
+        return; // duplicate, not goodput
+    }
+    m_packetsSentByNodes[source]--;
+    m_traffic.goodputBytes += packet->GetSize();
+    m_traffic.delivered++;
+    Time delay = Simulator::Now() - seqTs.GetTs();
+    m_traffic.delaySum += delay;
+    m_traffic.delaysMs.push_back(delay.GetSeconds() * 1000);
+}
+
+bool
+LraExample::IsRoutingControl(const Ipv4Header& header, Ptr<const Packet> payload) const
+{
+    if (IsLra())
+    {
+        if (header.GetProtocol() != LraRoutingProtocol::LRA_PROTOCOL)
+        {
+            return false;
+        }
+        // Aggregate frames carry data packets
+        LraHeader lraHeader;
+        payload->PeekHeader(lraHeader);
+        return lraHeader.GetType() != LRA_AGGREGATE;
+    }
+    UdpHeader udp;
+    if (header.GetProtocol() != UdpL4Protocol::PROT_NUMBER || !payload->PeekHeader(udp))
+    {
+        return false;
+    }
+    // Well-known ports of the stock protocols
+    uint16_t port = udp.GetDestinationPort();
+    return (routing == "aodv" && port == 654) || (routing == "olsr" && port == 698) ||
+           (routing == "dsdv" && port == 269);
+}
+
+double
+LraExample::GetAverageHopCount() const
+{
+    return m_hopPackets > 0 ? double(m_hopSum) / m_hopPackets : 0;
+}
+
+void
+LraExample::TraceSinkDelivery(std::string ctx,
+                              const Ipv4Header& header,
+                              Ptr<const Packet> packet,
+                              uint32_t interface)
+{
+    UdpHeader udp;
+    if (header.GetProtocol() != UdpL4Protocol::PROT_NUMBER || !packet->PeekHeader(udp) ||
+        udp.GetDestinationPort() != m_dataPort)
+    {
+        return;
+    }
+    // Same metric as LraRoutingProtocol::GetAverageHopCount: TTL decrements from the default 64
+    m_hopSum += 64 - header.GetTtl();
+    m_hopPackets++;
+    m_sinkDeliveries[GetNodeIdFromContext(ctx)]++;
+}
+
+void
+LraExample::TraceIpTx(std::string ctx, Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+    m_ipTransmissions++;
+    Ptr<Packet> payload = packet->Copy();
+    Ipv4Header header;
+    payload->RemoveHeader(header);
+    if (IsRoutingControl(header, payload))
+    {
+        m_controlPackets++;
+        m_controlBytes += packet->GetSize();
+    }
+}
+
 uint32_t
 LraExample::GetNodeIdFromContext(std::string ctx)
 {
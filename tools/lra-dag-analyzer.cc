@@ -0,0 +1,116 @@
+/*
+ * Offline analyzer for the DAG snapshots written by
+ * lra_gabriele_messina_benchmark --dagInterval=<s> --dagFile=<file>.
+ *
+ * Build (no ns-3 needed):
+ *   g++ -std=c++17 -O2 -I protocol tools/lra-dag-analyzer.cc protocol/lra-dag-snapshot.cc \
+ *       -o lra-dag-analyzer
+ *
+ * Usage:
+ *   lra-dag-analyzer <snapshots> [--csv=<file>]
+ *
+ * Prints the metrics of every snapshot, then each disruption (a converged
+ * snapshot followed by a non converged one) with its time to reconverge.
+ */
+
+#include "lra-dag-snapshot.h"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace ns3;
+
+int
+main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <snapshots> [--csv=<file>]" << std::endl;
+        return 1;
+    }
+
+    std::string csvFile;
+    for (int i = 2; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg.rfind("--csv=", 0) == 0)
+            csvFile = arg.substr(6);
+        else
+        {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    LraDagSnapshotReader reader;
+    if (!reader.Open(argv[1]))
+    {
+        std::cerr << argv[1] << " is not an LRA DAG snapshot file." << std::endl;
+        return 1;
+    }
+
+    std::ofstream csv;
+    if (!csvFile.empty())
+    {
+        csv.open(csvFile);
+        csv << "time,edges,cycles,nodes_in_cycles,unrouted,unrouted_connected,partitions,"
+               "disconnected,max_depth,avg_depth,converged\n";
+    }
+
+    std::cout << reader.addresses.size() << " nodes, " << reader.sinks.size() << " sink(s)\n";
+    std::cout << "time(s)\tedges\tcycles\tinCycle\tunrouted\tpartitions\tdepth(max/avg)\n";
+
+    LraDagSnapshot snapshot;
+    uint32_t snapshots = 0;
+    uint32_t loopySnapshots = 0;
+    bool previousConverged = false;
+    bool disrupted = false;
+    double disruptionTime = 0;
+    uint32_t disruptions = 0;
+    uint32_t recovered = 0;
+    double reconvergeSum = 0;
+    while (reader.Next(snapshot))
+    {
+        LraDagMetrics m = AnalyzeDag(reader.addresses.size(), reader.sinks, snapshot.edges);
+        double t = snapshot.timeNs / 1e9;
+        snapshots++;
+        loopySnapshots += (m.cycles > 0);
+
+        std::cout << std::fixed << std::setprecision(3) << t << "\t" << snapshot.edges.size()
+                  << "\t" << m.cycles << "\t" << m.nodesInCycles << "\t" << m.unrouted << "("
+                  << m.unroutedConnected << ")\t" << m.partitions << "(" << m.disconnected
+                  << ")\t" << m.maxDepth << "/" << std::setprecision(2) << m.avgDepth
+                  << (m.IsConverged() ? "" : "\t*") << "\n";
+        if (csv.is_open())
+        {
+            csv << t << "," << snapshot.edges.size() << "," << m.cycles << "," << m.nodesInCycles
+                << "," << m.unrouted << "," << m.unroutedConnected << "," << m.partitions << ","
+                << m.disconnected << "," << m.maxDepth << "," << m.avgDepth << ","
+                << m.IsConverged() << "\n";
+        }
+
+        if (previousConverged && !m.IsConverged())
+        {
+            disrupted = true;
+            disruptionTime = t;
+            disruptions++;
+        }
+        else if (disrupted && m.IsConverged())
+        {
+            disrupted = false;
+            recovered++;
+            reconvergeSum += t - disruptionTime;
+            std::cout << "  reconverged after " << t - disruptionTime << " s\n";
+        }
+        previousConverged = m.IsConverged();
+    }
+
+    std::cout << snapshots << " snapshots, " << loopySnapshots << " with loops, " << disruptions
+              << " disruptions, " << recovered << " reconverged";
+    if (recovered > 0)
+        std::cout << " (mean time to reconverge " << reconvergeSum / recovered << " s)";
+    std::cout << "\n";
+    return 0;
+}
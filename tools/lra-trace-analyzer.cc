@@ -0,0 +1,241 @@
+/*
+ * Offline analyzer for the binary event trace written by
+ * lra_gabriele_messina_benchmark --binaryTrace=<file>.
+ *
+ * Build (no ns-3 needed):
+ *   g++ -std=c++17 -O2 -I protocol tools/lra-trace-analyzer.cc -o lra-trace-analyzer
+ *
+ * Usage:
+ *   lra-trace-analyzer <trace> [--node=<id>] [--csv=<file>]
+ *
+ * Without options prints summary statistics; --node prints the timeline of one
+ * node, --csv writes the per-node statistics table.
+ */
+
+#include "lra-trace-format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+namespace
+{
+
+struct NodeStats
+{
+    uint64_t events[LRA_TRACE_EVENT_TYPES] = {};
+    double distance = 0; // Meters travelled, from consecutive course changes
+    bool hasPosition = false;
+    float lastX = 0;
+    float lastY = 0;
+    int64_t firstNs = -1;
+    int64_t lastNs = -1;
+};
+
+const char* EVENT_NAMES[LRA_TRACE_EVENT_TYPES] = {"course",
+                                                    "link",
+                                                    "reversal",
+                                                    "forward",
+                                                    "drop",
+                                                    "loop",
+                                                    "partition",
+                                                    "rejoin"};
+
+std::string
+FormatAddress(uint32_t address)
+{
+    std::ostringstream os;
+    os << ((address >> 24) & 0xff) << "." << ((address >> 16) & 0xff) << "."
+       << ((address >> 8) & 0xff) << "." << (address & 0xff);
+    return os.str();
+}
+
+void
+PrintRecord(const LraTraceRecord& r)
+{
+    std::cout << std::fixed << std::setprecision(6) << r.timeNs / 1e9 << "s\tnode " << r.node
+              << "\t";
+    switch (r.type)
+    {
+    case LRA_TRACE_COURSE_CHANGE:
+        std::cout << "course pos=(" << r.f[0] << "," << r.f[1] << ") vel=(" << r.f[2] << ","
+                  << r.f[3] << ")";
+        break;
+    case LRA_TRACE_LINK_STATE:
+        std::cout << "link " << FormatAddress(r.u[0]) << " " << r.i[1] << " -> " << r.i[2];
+        break;
+    case LRA_TRACE_REVERSAL:
+        std::cout << "reversal of " << r.u[0] << " links";
+        break;
+    case LRA_TRACE_FORWARD:
+        std::cout << "forward uid=" << r.u[0] << " via " << FormatAddress(r.u[1]) << " "
+                  << FormatAddress(r.u[2]) << " -> " << FormatAddress(r.u[3]);
+        break;
+    case LRA_TRACE_DROP:
+        std::cout << "drop uid=" << r.u[0] << " reason=" << r.u[1] << " "
+                  << FormatAddress(r.u[2]) << " -> " << FormatAddress(r.u[3]);
+        break;
+    case LRA_TRACE_LOOP:
+        std::cout << "loop through " << FormatAddress(r.u[0]);
+        break;
+    case LRA_TRACE_PARTITION:
+        std::cout << "partition detected by " << FormatAddress(r.u[0]);
+        break;
+    case LRA_TRACE_REJOIN:
+        std::cout << "rejoin through " << FormatAddress(r.u[0]);
+        break;
+    default:
+        std::cout << "unknown event " << unsigned(r.type);
+    }
+    std::cout << "\n";
+}
+
+void
+Account(std::map<uint32_t, NodeStats>& stats, const LraTraceRecord& r)
+{
+    NodeStats& s = stats[r.node];
+    s.events[r.type]++;
+    if (s.firstNs < 0)
+        s.firstNs = r.timeNs;
+    s.lastNs = r.timeNs;
+    if (r.type == LRA_TRACE_COURSE_CHANGE)
+    {
+        // Motion between course changes is linear, so the segment length is exact
+        if (s.hasPosition)
+            s.distance += std::hypot(r.f[0] - s.lastX, r.f[1] - s.lastY);
+        s.hasPosition = true;
+        s.lastX = r.f[0];
+        s.lastY = r.f[1];
+    }
+}
+
+void
+PrintTop(const std::map<uint32_t, NodeStats>& stats, LraTraceEventType type, size_t n)
+{
+    std::vector<std::pair<uint64_t, uint32_t>> ranking;
+    for (const auto& entry : stats)
+        if (entry.second.events[type] > 0)
+            ranking.push_back({entry.second.events[type], entry.first});
+    if (ranking.empty())
+        return;
+    std::sort(ranking.rbegin(), ranking.rend());
+    std::cout << "Top nodes by " << EVENT_NAMES[type] << ":";
+    for (size_t i = 0; i < std::min(n, ranking.size()); ++i)
+        std::cout << " " << ranking[i].second << "(" << ranking[i].first << ")";
+    std::cout << "\n";
+}
+
+} // namespace
+
+int
+main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <trace> [--node=<id>] [--csv=<file>]" << std::endl;
+        return 1;
+    }
+
+    long timelineNode = -1;
+    std::string csvFile;
+    for (int i = 2; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg.rfind("--node=", 0) == 0)
+            timelineNode = std::stol(arg.substr(7));
+        else if (arg.rfind("--csv=", 0) == 0)
+            csvFile = arg.substr(6);
+        else
+        {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    std::ifstream file(argv[1], std::ios::binary);
+    LraTraceFileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, LRA_TRACE_MAGIC, sizeof(header.magic)) != 0)
+    {
+        std::cerr << argv[1] << " is not an LRA binary trace." << std::endl;
+        return 1;
+    }
+    if (header.version != LRA_TRACE_VERSION || header.recordSize != sizeof(LraTraceRecord))
+    {
+        std::cerr << "Unsupported trace version " << header.version << " (record size "
+                  << header.recordSize << ")." << std::endl;
+        return 1;
+    }
+
+    std::map<uint32_t, NodeStats> stats;
+    std::map<uint32_t, uint64_t> dropReasons;
+    uint64_t totals[LRA_TRACE_EVENT_TYPES] = {};
+    uint64_t nRecords = 0;
+    int64_t endNs = 0;
+
+    std::vector<LraTraceRecord> block(4096);
+    while (file)
+    {
+        file.read(reinterpret_cast<char*>(block.data()), block.size() * sizeof(LraTraceRecord));
+        size_t n = file.gcount() / sizeof(LraTraceRecord);
+        for (size_t i = 0; i < n; ++i)
+        {
+            const LraTraceRecord& r = block[i];
+            if (r.type >= LRA_TRACE_EVENT_TYPES)
+                continue;
+            nRecords++;
+            totals[r.type]++;
+            endNs = std::max(endNs, r.timeNs);
+            Account(stats, r);
+            if (r.type == LRA_TRACE_DROP)
+                dropReasons[r.u[1]]++;
+            if (timelineNode >= 0 && r.node == static_cast<uint32_t>(timelineNode))
+                PrintRecord(r);
+        }
+    }
+
+    if (timelineNode >= 0)
+        return 0;
+
+    std::cout << nRecords << " events from " << stats.size() << " nodes, last at "
+              << endNs / 1e9 << " s\n";
+    for (int t = 0; t < LRA_TRACE_EVENT_TYPES; ++t)
+        std::cout << "  " << std::setw(8) << EVENT_NAMES[t] << ": " << totals[t] << "\n";
+    for (const auto& reason : dropReasons)
+        std::cout << "  drops with reason " << reason.first << ": " << reason.second << "\n";
+
+    double distance = 0;
+    for (const auto& entry : stats)
+        distance += entry.second.distance;
+    if (!stats.empty())
+        std::cout << "Average distance travelled: " << distance / stats.size() << " m\n";
+    PrintTop(stats, LRA_TRACE_REVERSAL, 10);
+    PrintTop(stats, LRA_TRACE_DROP, 10);
+    PrintTop(stats, LRA_TRACE_FORWARD, 10);
+    PrintTop(stats, LRA_TRACE_LOOP, 10);
+
+    if (!csvFile.empty())
+    {
+        std::ofstream csv(csvFile);
+        csv << "node,course_changes,link_changes,reversals,forwards,drops,loops,partitions,"
+               "rejoins,distance,first_event,last_event\n";
+        for (const auto& entry : stats)
+        {
+            const NodeStats& s = entry.second;
+            csv << entry.first;
+            for (int t = 0; t < LRA_TRACE_EVENT_TYPES; ++t)
+                csv << "," << s.events[t];
+            csv << "," << s.distance << "," << s.firstNs / 1e9 << "," << s.lastNs / 1e9 << "\n";
+        }
+    }
+    return 0;
+}